@@ -185,6 +185,11 @@ Canvas::~Canvas()
     zoomScale.removeListener(this);
     editor->removeModifierKeyListener(this);
     pd->unregisterMessageListener(patch.getUncheckedPointer(), this);
+
+    if (showDSPLoad) {
+        pd->dspProfiler->removeChangeListener(this);
+        pd->dspProfiler->removeUser();
+    }
 }
 
 bool Canvas::updateFramebuffers(NVGcontext* nvg, Rectangle<int> invalidRegion, int maxUpdateTimeMs)
@@ -318,6 +323,9 @@ void Canvas::performRender(NVGcontext* nvg, Rectangle<int> invalidRegion)
     auto const halfSize = infiniteCanvasSize / 2;
     auto const zoom = getValue<float>(zoomScale);
 
+    renderStatistics = {};
+    NVGDrawCallCounter drawCallCounter(nvg, renderStatistics);
+
     auto background = findColour(PlugDataColour::canvasBackgroundColourId);
     auto backgroundColour = convertColour(background);
     auto borderLinesColour = convertColour(findColour(PlugDataColour::canvasDotsColourId).interpolatedWith(background, 0.2f));
@@ -622,7 +630,8 @@ void Canvas::updatePatchSnapshot()
 
 void Canvas::renderAllObjects(NVGcontext* nvg, Rectangle<int> area)
 {
-    for (auto* obj : objects) {
+    // The index includes the object's label, so we also find objects that are outside the area, but have a label inside it
+    for (auto* obj : objectSpatialIndex.query(area)) {
         auto b = obj->getBounds();
         {
             NVGScopedState scopedState(nvg);
@@ -648,14 +657,14 @@ void Canvas::renderAllConnections(NVGcontext* nvg, Rectangle<int> area)
     Array<Connection*> connectionsToDrawSelected;
     Connection* hovered = nullptr;
 
-    for (auto* connection : connections) {
+    for (auto* connection : connectionSpatialIndex.query(area)) {
         NVGScopedState scopedState(nvg);
         if (connection->intersectsRectangle(area) && connection->isVisible()) {
             if (connection->isMouseHovering())
                 hovered = connection;
-            else if (!connection->isSelected())
+            else if (!connection->isSelected()) {
                 connection->render(nvg);
-            else
+            } else
                 connectionsToDrawSelected.add(connection);
             if (showConnectionOrder) {
                 connectionsToDraw.add(connection);
@@ -714,6 +723,11 @@ bool Canvas::shouldShowIndex()
     return showIndex && !presentationMode.getValue();
 }
 
+bool Canvas::shouldShowDSPLoad()
+{
+    return showDSPLoad && !presentationMode.getValue() && !isGraph;
+}
+
 bool Canvas::shouldShowConnectionDirection()
 {
     return showConnectionDirection;
@@ -761,11 +775,30 @@ void Canvas::updateOverlays()
     showConnectionDirection = overlayState & Direction;
     showConnectionActivity = overlayState & ConnectionActivity;
 
+    // The profiler only instruments the DSP chain while something is showing its results
+    bool const shouldShowLoad = overlayState & DSPLoad;
+    if (shouldShowLoad != showDSPLoad) {
+        showDSPLoad = shouldShowLoad;
+        if (showDSPLoad) {
+            pd->dspProfiler->addUser();
+            pd->dspProfiler->addChangeListener(this);
+        } else {
+            pd->dspProfiler->removeChangeListener(this);
+            pd->dspProfiler->removeUser();
+        }
+    }
+
     orderConnections();
 
     repaint();
 }
 
+void Canvas::changeListenerCallback(ChangeBroadcaster* source)
+{
+    // New DSP profiler results
+    repaint();
+}
+
 void Canvas::jumpToOrigin()
 {
     if (viewport)
@@ -896,14 +929,64 @@ void Canvas::saveAs(std::function<void()> const& nestedCallback)
 
 void Canvas::handleAsyncUpdate()
 {
-    performSynchronise();
+    performSynchronise(true);
 }
 
-void Canvas::synchronise()
+void Canvas::synchronise(bool onlyChangedObjects)
 {
+    if (!onlyChangedObjects)
+        fullSynchronisePending = true;
+
     triggerAsyncUpdate();
 }
 
+// Everything that updateIolets, updateBounds and the object GUI read from pd, so we know when we can skip them
+// Objects that aren't t_objects, like scalars, return 0 and are always updated
+static uint64 getSyncSignature(t_gobj* obj)
+{
+    auto* object = pd::Interface::checkObject(obj);
+    if (!object)
+        return 0;
+
+    uint64 signature = 14695981039346656037ull;
+    auto combine = [&signature](uint64 value) {
+        signature = (signature ^ value) * 1099511628211ull;
+    };
+
+    for (auto const value : { object->te_xpix, object->te_ypix, static_cast<int>(object->te_width), static_cast<int>(object->te_type), obj_ninlets(object), obj_noutlets(object) }) {
+        combine(static_cast<uint32>(value));
+    }
+
+    // The text can change without changing the number of atoms, for example when editing a comment or a message
+    if (object->te_binbuf) {
+        auto const numAtoms = binbuf_getnatom(object->te_binbuf);
+        auto const* atoms = binbuf_getvec(object->te_binbuf);
+        combine(static_cast<uint32>(numAtoms));
+        for (int i = 0; i < numAtoms; i++) {
+            combine(static_cast<uint32>(atoms[i].a_type));
+            switch (atoms[i].a_type) {
+            case A_FLOAT: {
+                uint32 bits;
+                std::memcpy(&bits, &atoms[i].a_w.w_float, sizeof(bits));
+                combine(bits);
+                break;
+            }
+            case A_SYMBOL:
+            case A_DOLLSYM:
+                combine(reinterpret_cast<uint64>(atoms[i].a_w.w_symbol));
+                break;
+            case A_DOLLAR:
+                combine(static_cast<uint32>(atoms[i].a_w.w_index));
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    return signature ? signature : 1;
+}
+
 void Canvas::synchroniseAllCanvases()
 {
     for (auto* editorWindow : pd->getEditors()){
@@ -913,6 +996,29 @@ void Canvas::synchroniseAllCanvases()
     }
 }
 
+// This patch can also be a subpatch or abstraction inside the patch of another canvas, so the search trees of the canvases that contain it are out of date too
+// Canvases of unrelated patches, and of subpatches inside this one, don't show anything that changed here
+void Canvas::invalidateSearchTrees()
+{
+    needsSearchUpdate = true;
+
+    // Includes this patch itself, it could also be open in the other half of a split view
+    Array<t_glist*> containingPatches;
+    if (auto patchPtr = patch.getPointer()) {
+        for (auto* glist = patchPtr.get(); glist; glist = glist->gl_owner) {
+            containingPatches.add(glist);
+        }
+    }
+
+    for (auto* editorWindow : pd->getEditors()) {
+        for (auto* canvas : editorWindow->getTabComponent().getCanvases()) {
+            if (containingPatches.contains(canvas->patch.getUncheckedPointer())) {
+                canvas->needsSearchUpdate = true;
+            }
+        }
+    }
+}
+
 void Canvas::synchroniseSplitCanvas()
 {
     for (auto* canvas : editor->getTabComponent().getVisibleCanvases()) {
@@ -922,8 +1028,12 @@ void Canvas::synchroniseSplitCanvas()
 
 // Synchronise state with pure-data
 // Used for loading and for complicated actions like undo/redo
-void Canvas::performSynchronise()
+void Canvas::performSynchronise(bool onlyChangedObjects)
 {
+    // Always consume the pending flag, otherwise the next incremental sync would update everything again
+    auto const fullSynchroniseWasPending = fullSynchronisePending.exchange(false);
+    auto const updateAllObjects = !onlyChangedObjects || fullSynchroniseWasPending;
+
     if(auto patchPtr = patch.getPointer()) {
         patch.setCurrent();
         pd->sendMessagesFromQueue();
@@ -932,6 +1042,24 @@ void Canvas::performSynchronise()
         return;
     }
 
+    auto pdObjects = patch.getObjects();
+
+    // Read what we need to know about every object under a single lock
+    std::vector<uint64> syncSignatures(pdObjects.size(), 0);
+    if (auto patchPtr = patch.getPointer()) {
+        for (size_t i = 0; i < pdObjects.size(); i++) {
+            if (auto* obj = pdObjects[i].getRaw<t_gobj>())
+                syncSignatures[i] = getSyncSignature(obj);
+        }
+    }
+
+    // Index the pd objects by pointer, so we can look up their position in O(1) instead of scanning the patch for every object
+    std::unordered_map<t_gobj*, size_t> pdObjectIndex;
+    pdObjectIndex.reserve(pdObjects.size());
+    for (size_t i = 0; i < pdObjects.size(); i++) {
+        pdObjectIndex.emplace(pdObjects[i].getRawUnchecked<t_gobj>(), i);
+    }
+
     // Remove deleted connections
     for (int n = connections.size() - 1; n >= 0; n--) {
         if (!connections[n]->getPointer()) {
@@ -942,9 +1070,10 @@ void Canvas::performSynchronise()
     // Remove deleted objects
     for (int n = objects.size() - 1; n >= 0; n--) {
         auto* object = objects[n];
+        auto* objectPtr = object->getPointer();
 
         // If the object is showing it's initial editor, meaning no object was assigned yet, allow it to exist without pointing to an object
-        if ((!object->getPointer() || patch.objectWasDeleted(object->getPointer())) && !object->isInitialEditorShown()) {
+        if ((!objectPtr || !pdObjectIndex.contains(objectPtr)) && !object->isInitialEditorShown()) {
             setSelected(object, false, false);
             objects.remove(n);
         }
@@ -957,29 +1086,44 @@ void Canvas::performSynchronise()
         }
     }
 
-    auto pdObjects = patch.getObjects();
+    std::unordered_map<t_gobj*, Object*> objectIndex;
+    objectIndex.reserve(objects.size() + pdObjects.size());
+    for (auto* object : objects) {
+        if (auto* objectPtr = object->getPointer())
+            objectIndex.emplace(objectPtr, object);
+    }
+
+    std::vector<t_gobj*> synchronisedObjects;
+    synchronisedObjects.reserve(pdObjects.size());
+    bool objectsWereAdded = false;
 
-    for (auto object : pdObjects) {
-        auto* it = std::find_if(objects.begin(), objects.end(), [&object](Object* b) { return b->getPointer() && b->getPointer() == object.getRawUnchecked<void>(); });
+    for (size_t i = 0; i < pdObjects.size(); i++) {
+        auto& object = pdObjects[i];
         if (!object.isValid())
             continue;
 
-        if (it == objects.end()) {
-            auto* newObject = objects.add(new Object(object, this));
-            newObject->toFront(false);
+        auto* objectPtr = object.getRawUnchecked<t_gobj>();
+        synchronisedObjects.push_back(objectPtr);
 
-            if (newObject->gui && newObject->gui->getLabel())
-                newObject->gui->getLabel()->toFront(false);
+        auto it = objectIndex.find(objectPtr);
+        if (it == objectIndex.end()) {
+            auto* newObject = objects.add(new Object(object, this));
+            newObject->syncSignature = syncSignatures[i];
+            objectIndex.emplace(objectPtr, newObject);
+            objectsWereAdded = true;
         } else {
-            auto* object = *it;
+            auto* object = it->second;
+
+            auto const signature = syncSignatures[i];
+            if (!updateAllObjects && signature && signature == object->syncSignature)
+                continue;
+
+            object->syncSignature = signature;
 
             // Check if number of inlets/outlets is correct
             object->updateIolets();
             object->updateBounds();
 
-            object->toFront(false);
-            if (object->gui && object->gui->getLabel())
-                object->gui->getLabel()->toFront(false);
             if (object->gui)
                 object->gui->update();
         }
@@ -987,13 +1131,38 @@ void Canvas::performSynchronise()
 
     // Make sure objects have the same order
     std::sort(objects.begin(), objects.end(),
-        [&pdObjects](Object* first, Object* second) mutable {
-            size_t idx1 = std::find(pdObjects.begin(), pdObjects.end(), first->getPointer()) - pdObjects.begin();
-            size_t idx2 = std::find(pdObjects.begin(), pdObjects.end(), second->getPointer()) - pdObjects.begin();
+        [&pdObjectIndex, numObjects = pdObjects.size()](Object* first, Object* second) {
+            auto it1 = pdObjectIndex.find(first->getPointer());
+            auto it2 = pdObjectIndex.find(second->getPointer());
+            size_t idx1 = it1 != pdObjectIndex.end() ? it1->second : numObjects;
+            size_t idx2 = it2 != pdObjectIndex.end() ? it2->second : numObjects;
 
             return idx1 < idx2;
         });
 
+    for (int i = 0; i < objects.size(); i++) {
+        objectSpatialIndex.setOrder(objects[i], i);
+    }
+
+    // Restoring the z-order is O(n) per object, so only do it if the order in pd actually changed since the last sync
+    if (objectsWereAdded || synchronisedObjects != lastSynchronisedObjects) {
+        for (auto* object : objects) {
+            if (!object->getPointer())
+                continue;
+
+            object->toFront(false);
+            if (object->gui && object->gui->getLabel())
+                object->gui->getLabel()->toFront(false);
+        }
+        lastSynchronisedObjects = std::move(synchronisedObjects);
+    }
+
+    std::unordered_map<t_outconnect*, Connection*> connectionIndex;
+    connectionIndex.reserve(connections.size());
+    for (auto* connection : connections) {
+        connectionIndex.emplace(connection->getPointer(), connection);
+    }
+
     auto pdConnections = patch.getConnections();
 
     for (auto& connection : pdConnections) {
@@ -1002,24 +1171,18 @@ void Canvas::performSynchronise()
         Iolet *inlet = nullptr, *outlet = nullptr;
 
         // Find the objects that this connection is connected to
-        for (auto* obj : objects) {
-            if (outobj && &outobj->te_g == obj->getPointer()) {
-
-                // Check if we have enough outlets, should never return false
-                if (isPositiveAndBelow(obj->numInputs + outno, obj->iolets.size())) {
-                    outlet = obj->iolets[obj->numInputs + outno];
-                } else {
-                    break;
-                }
+        if (outobj) {
+            auto it = objectIndex.find(&outobj->te_g);
+            // Check if we have enough outlets, should never return false
+            if (it != objectIndex.end() && isPositiveAndBelow(it->second->numInputs + outno, it->second->iolets.size())) {
+                outlet = it->second->iolets[it->second->numInputs + outno];
             }
-            if (inobj && &inobj->te_g == obj->getPointer()) {
-
-                // Check if we have enough inlets, should never return false
-                if (isPositiveAndBelow(inno, obj->iolets.size())) {
-                    inlet = obj->iolets[inno];
-                } else {
-                    break;
-                }
+        }
+        if (inobj) {
+            auto it = objectIndex.find(&inobj->te_g);
+            // Check if we have enough inlets, should never return false
+            if (it != objectIndex.end() && isPositiveAndBelow(inno, it->second->iolets.size())) {
+                inlet = it->second->iolets[inno];
             }
         }
 
@@ -1029,22 +1192,18 @@ void Canvas::performSynchronise()
             continue;
         }
 
-        auto* it = std::find_if(connections.begin(), connections.end(),
-            [c_ptr = ptr](auto* c) {
-                return c_ptr == c->getPointer();
-            });
-
-        if (it == connections.end()) {
-            connections.add(new Connection(this, inlet, outlet, ptr));
+        auto it = connectionIndex.find(ptr);
+        if (it == connectionIndex.end()) {
+            connectionIndex.emplace(ptr, connections.add(new Connection(this, inlet, outlet, ptr)));
         } else {
-            auto& c = *(*it);
+            auto& c = *it->second;
 
             // This is necessary to make resorting a subpatchers iolets work
             // And it can't hurt to check if the connection is valid anyway
             if (c.inlet != inlet || c.outlet != outlet) {
-                int idx = connections.indexOf(*it);
-                connections.removeObject(*it);
-                connections.insert(idx, new Connection(this, inlet, outlet, ptr));
+                int idx = connections.indexOf(it->second);
+                connections.removeObject(it->second);
+                it->second = connections.insert(idx, new Connection(this, inlet, outlet, ptr));
             } else {
                 c.popPathState();
             }
@@ -1061,9 +1220,9 @@ void Canvas::performSynchronise()
     editor->updateCommandStatus();
     repaint();
 
-    needsSearchUpdate = true;
+    invalidateSearchTrees();
 
-    pd->updateObjectImplementations();
+    pd->updateObjectImplementations(patch.getUncheckedPointer());
 }
 
 void Canvas::updateDrawables()
@@ -1231,8 +1390,9 @@ void Canvas::mouseDrag(MouseEvent const& e)
         bool hasToggled = false;
 
         // Behaviour for dragging over toggles, bang and radiogroup to toggle them
-        for (auto* object : objects) {
-            if (!object->getBounds().contains(e.getEventRelativeTo(this).getPosition()) || !object->gui)
+        auto const position = e.getEventRelativeTo(this).getPosition();
+        for (auto* object : objectSpatialIndex.query(Rectangle<int>(position, position.translated(1, 1)))) {
+            if (!object->getBounds().contains(position) || !object->gui)
                 continue;
 
             if (auto* obj = object->gui.get()) {
@@ -1330,9 +1490,10 @@ void Canvas::mouseUp(MouseEvent const& e)
 
     // TODO: this is a hack, find a better solution
     if (connectingWithDrag) {
-        for (auto* obj : objects) {
+        auto relativeEvent = e.getEventRelativeTo(this);
+        auto searchArea = Rectangle<int>(relativeEvent.getPosition(), relativeEvent.getPosition()).expanded(20 + Object::margin);
+        for (auto* obj : objectSpatialIndex.query(searchArea)) {
             for (auto* iolet : obj->iolets) {
-                auto relativeEvent = e.getEventRelativeTo(this);
                 if (iolet->getCanvasBounds().expanded(20).contains(relativeEvent.getPosition())) {
                     iolet->mouseUp(relativeEvent);
                 }
@@ -1559,7 +1720,7 @@ void Canvas::dragAndDropPaste(String const& patchString, Point<int> mousePos, in
     deselectAll();
 
     // Load state from pd
-    performSynchronise();
+    performSynchronise(true);
 
     patch.setCurrent();
 
@@ -1605,7 +1766,7 @@ void Canvas::pasteSelection()
     deselectAll();
 
     // Load state from pd
-    performSynchronise();
+    performSynchronise(true);
 
     patch.setCurrent();
 
@@ -1675,7 +1836,7 @@ void Canvas::duplicateSelection()
     deselectAll();
 
     // Load state from pd immediately
-    performSynchronise();
+    performSynchronise(true);
 
     auto* patchPtr = patch.getPointer().get();
     if (!patchPtr)
@@ -1785,7 +1946,7 @@ void Canvas::removeSelection()
     deselectAll();
 
     // Load state from pd
-    synchronise();
+    synchronise(true);
     handleUpdateNowIfNeeded();
 
     patch.endUndoSequence("Remove object/s");
@@ -1813,7 +1974,7 @@ void Canvas::removeSelectedConnections()
     patch.endUndoSequence("Remove connection/s");
 
     // Load state from pd
-    synchronise();
+    synchronise(true);
     handleUpdateNowIfNeeded();
 
     synchroniseSplitCanvas();
@@ -1870,7 +2031,7 @@ void Canvas::tidySelection()
         pd::Interface::tidy(patchPtr.get(), selectedObjects);
     }
     
-    synchronise();
+    synchronise(true);
 }
 
 void Canvas::triggerizeSelection()
@@ -1894,7 +2055,7 @@ void Canvas::triggerizeSelection()
         triggerizedObject = pd::Interface::triggerize(patchPtr.get(), selectedObjects, connection);
     }
 
-    performSynchronise();
+    performSynchronise(true);
     
     if(triggerizedObject) {
         for(auto* object : objects)
@@ -2044,7 +2205,7 @@ void Canvas::encapsulateSelection()
 
     pd->unlockAudioThread();
 
-    synchronise();
+    synchronise(true);
     handleUpdateNowIfNeeded();
 
     patch.deselectAll();
@@ -2070,7 +2231,7 @@ void Canvas::connectSelection()
         pd::Interface::connectSelection(patchPtr.get(), selectedObjects, connection);
     }
     
-    synchronise();
+    synchronise(true);
 }
 
 void Canvas::cancelConnectionCreation()
@@ -2233,7 +2394,7 @@ void Canvas::alignObjects(Align alignment)
         break;
     }
 
-    performSynchronise();
+    performSynchronise(true);
 
     for (auto* connection : connections) {
         connection->forceUpdate();
@@ -2459,27 +2620,42 @@ bool Canvas::isPointOutsidePluginArea(Point<int> point)
 void Canvas::findLassoItemsInArea(Array<WeakReference<Component>>& itemsFound, Rectangle<int> const& area)
 {
     auto const lassoBounds = area.withWidth(jmax(2, area.getWidth())).withHeight(jmax(2, area.getHeight()));
+    auto const modifierKeyDown = ModifierKeys::getCurrentModifiers().isAnyModifierKeyDown();
 
-    for (auto* object : objects) {
+    // Only objects and connections near the lasso can be inside of it, everything else only needs to be deselected
+    std::unordered_set<Component*> insideLasso;
+    for (auto* object : objectSpatialIndex.query(lassoBounds)) {
         if (lassoBounds.intersects(object->getSelectableBounds())) {
             itemsFound.add(object);
-        } else if (!ModifierKeys::getCurrentModifiers().isAnyModifierKeyDown()) {
-            setSelected(object, false, false);
+            insideLasso.insert(object);
         }
     }
 
-    for (auto& connection : connections) {
+    std::unordered_set<Component*> touchingLasso;
+    for (auto* connection : connectionSpatialIndex.query(lassoBounds)) {
         // If total bounds don't intersect, there can't be an intersection with the line
         // This is cheaper than checking the path intersection, so do this first
-        if (!connection->getBounds().intersects(lassoBounds)) {
-            setSelected(connection, false, false);
+        if (!connection->getBounds().intersects(lassoBounds))
             continue;
-        }
 
         // Check if path intersects with lasso
         if (connection->intersects(lassoBounds.toFloat())) {
             itemsFound.add(connection);
-        } else if (!ModifierKeys::getCurrentModifiers().isAnyModifierKeyDown()) {
+            insideLasso.insert(connection);
+        } else {
+            touchingLasso.insert(connection);
+        }
+    }
+
+    for (auto* object : getSelectionOfType<Object>()) {
+        if (!modifierKeyDown && !insideLasso.contains(object)) {
+            setSelected(object, false, false);
+        }
+    }
+
+    // Connections with bounds that don't touch the lasso are always deselected
+    for (auto* connection : getSelectionOfType<Connection>()) {
+        if (!insideLasso.contains(connection) && (!modifierKeyDown || !touchingLasso.contains(connection))) {
             setSelected(connection, false, false);
         }
     }
@@ -2540,7 +2716,7 @@ void Canvas::receiveMessage(t_symbol* symbol, pd::Atom const atoms[8], int numAt
     case hash("cut"):
     case hash("disconnect"): {
         // This will trigger an asyncupdater, so it's thread-safe to do this here
-        synchronise();
+        synchronise(true);
         break;
     }
     case hash("editmode"): {
@@ -17,6 +17,7 @@ using namespace juce::gl;
 
 #include "ObjectGrid.h"          // move to impl
 #include "Utility/RateReducer.h" // move to impl
+#include "Utility/SpatialGrid.h"
 #include "Utility/ModifierKeyListener.h"
 #include "Components/CheckedTooltip.h"
 #include "Pd/MessageListener.h"
@@ -63,6 +64,7 @@ class Canvas : public Component
     , public ModifierKeyListener
     , public pd::MessageListener
     , public AsyncUpdater
+    , public ChangeListener
     , public NVGComponent {
 public:
     Canvas(PluginEditor* parent, pd::Patch::Ptr patch, Component* parentGraph = nullptr);
@@ -100,6 +102,7 @@ public:
 
     bool shouldShowObjectActivity();
     bool shouldShowIndex();
+    bool shouldShowDSPLoad();
     bool shouldShowConnectionDirection();
     bool shouldShowConnectionActivity();
 
@@ -108,14 +111,17 @@ public:
 
     void synchroniseAllCanvases();
     void synchroniseSplitCanvas();
-    void synchronise();
-    void performSynchronise();
+    // With onlyChangedObjects, objects whose position, size, text and iolets didn't change in pd are not updated
+    // That's enough for edits that add, remove, move or connect objects, but not when object properties might have changed
+    void synchronise(bool onlyChangedObjects = false);
+    void performSynchronise(bool onlyChangedObjects = false);
     void handleAsyncUpdate() override;
 
     void updateDrawables();
 
     bool keyPressed(KeyPress const& key) override;
     void valueChanged(Value& v) override;
+    void changeListenerCallback(ChangeBroadcaster* source) override;
 
     void tabChanged();
 
@@ -206,6 +212,15 @@ public:
 
     // Needs to be allocated before object and connection so they can deselect themselves in the destructor
     SelectedItemSet<WeakReference<Component>> selectedComponents;
+
+    // Keeps track of where objects and connections are, for render culling, lasso selection and hit-testing
+    // Also needs to be allocated before objects and connections, they remove themselves from it in their destructor
+    SpatialGrid<Object> objectSpatialIndex;
+    SpatialGrid<Connection> connectionSpatialIndex;
+
+    // Draw calls of the last frame that performRender drew, so benchmarks can see how much work a frame was
+    NVGRenderStatistics renderStatistics;
+
     OwnedArray<Object> objects;
     OwnedArray<Connection> connections;
     OwnedArray<ConnectionBeingCreated> connectionsBeingCreated;
@@ -220,6 +235,7 @@ public:
     bool connectionsBehind = true;
     bool showObjectActivity = false;
     bool showIndex = false;
+    bool showDSPLoad = false;
 
     bool showConnectionDirection = false;
     bool showConnectionActivity = false;
@@ -230,6 +246,7 @@ public:
     bool isDraggingLasso = false;
 
     bool needsSearchUpdate = false;
+    void invalidateSearchTrees();
 
     Value isGraphChild = SynchronousValue(var(false));
     Value hideNameAndArgs = SynchronousValue(var(false));
@@ -282,6 +299,12 @@ private:
 
     RateReducer canvasRateReducer = RateReducer(90);
 
+    // Order of the pd objects at the last synchronise, used to skip restoring the z-order when nothing moved
+    std::vector<t_gobj*> lastSynchronisedObjects;
+
+    // Set when a synchronise that has to update every object is waiting for the async update
+    std::atomic<bool> fullSynchronisePending = true;
+
     // Properties that can be shown in the inspector by right-clicking on canvas
     ObjectParameters parameters;
 
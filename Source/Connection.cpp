@@ -95,6 +95,7 @@ Connection::~Connection()
 {
     cnv->pd->unregisterMessageListener(ptr.getRawUnchecked<void>(), this);
     cnv->selectedComponents.removeChangeListener(this);
+    cnv->connectionSpatialIndex.remove(this);
 
     if (outlet) {
         outlet->repaint();
@@ -791,6 +792,16 @@ int Connection::getClosestLineIdx(Point<float> const& position, PathPlan const&
     return -1;
 }
 
+void Connection::moved()
+{
+    cnv->connectionSpatialIndex.update(this, getBounds());
+}
+
+void Connection::resized()
+{
+    cnv->connectionSpatialIndex.update(this, getBounds());
+}
+
 void Connection::pathChanged()
 {
     strokePath.clear();
@@ -1173,7 +1184,7 @@ void Connection::findPath()
     auto obstacles = Array<Rectangle<float>>();
     auto searchBounds = Rectangle<float>(pstart, pend);
 
-    for (auto* object : cnv->objects) {
+    for (auto* object : cnv->objectSpatialIndex.query(searchBounds.getSmallestIntegerContainer())) {
         if (object->getBounds().toFloat().intersects(searchBounds)) {
             obstacles.add(object->getBounds().toFloat());
         }
@@ -1252,7 +1263,7 @@ int Connection::findLatticePaths(PathPlan& bestPath, PathPlan& pathStack, Point<
     auto obstacles = Array<Object*>();
     auto searchBounds = Rectangle<float>(pstart, pend);
 
-    for (auto* object : cnv->objects) {
+    for (auto* object : cnv->objectSpatialIndex.query(searchBounds.getSmallestIntegerContainer())) {
         if (object->getBounds().toFloat().intersects(searchBounds)) {
             obstacles.add(object);
         }
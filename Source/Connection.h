@@ -88,6 +88,9 @@ public:
 
     void componentMovedOrResized(Component& component, bool wasMoved, bool wasResized) override;
 
+    void moved() override;
+    void resized() override;
+
     // Pathfinding
     int findLatticePaths(PathPlan& bestPath, PathPlan& pathStack, Point<float> start, Point<float> end, Point<float> increment);
 
@@ -133,6 +133,7 @@ public:
 
         object.add(new OverlaySelector(overlayTree, ActivationState, "activation_state", "Activity", "Object activity"));
         object.add(new OverlaySelector(overlayTree, Index, "index", "Index", "Object index in patch"));
+        object.add(new OverlaySelector(overlayTree, DSPLoad, "dsp_load", "DSP Load", "Share of DSP time used per object"));
 
         connection.add(new OverlaySelector(overlayTree, ConnectionActivity, "connection_activity", "Activity", "Connection activity"));
         connection.add(new OverlaySelector(overlayTree, Direction, "direction", "Direction", "Direction of connections"));
@@ -154,7 +155,7 @@ public:
                 addAndMakeVisible(item);
             }
         }
-        setSize(335, 200);
+        setSize(335, 228);
     }
 
     void valueChanged(Value& v) override
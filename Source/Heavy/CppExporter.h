@@ -54,6 +54,8 @@ public:
         if (shouldQuit)
             return true;
 
+        exportingView->startExportStep("Generating code");
+
         start(args.joinIntoString(" "));
 
         waitForProcessToFinish(-1);
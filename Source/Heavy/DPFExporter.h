@@ -188,6 +188,8 @@ public:
         if (shouldQuit)
             return true;
 
+        exportingView->startExportStep("Generating code");
+
         start(args.joinIntoString(" "));
 
         waitForProcessToFinish(-1);
@@ -218,21 +220,30 @@ public:
             auto make = bin.getChildFile("make" + exeSuffix);
             auto makefile = outputFile.getChildFile("Makefile");
 
+            exportingView->startExportStep("Restoring cache");
+
+            ExportCache cache("DPF", outputFile, name);
+            if (auto numUnchanged = cache.restore({ "build", "dpf/build" }, args.joinIntoString(" ") + " " + Toolchain::dir.getFullPathName())) {
+                exportingView->logToConsole("Reusing previous build: " + String(numUnchanged) + " of " + String(cache.getNumSourceFiles()) + " source files unchanged\n");
+            }
+
+            exportingView->startExportStep("Compiling");
+
 #if JUCE_MAC
-            Toolchain::startShellScript("make -j4 -f " + makefile.getFullPathName(), this);
+            Toolchain::startShellScript("make " + getMakeJobsFlag() + " -f " + makefile.getFullPathName(), this);
 #elif JUCE_WINDOWS
             auto path = "export PATH=\"$PATH:" + Toolchain::dir.getChildFile("bin").getFullPathName().replaceCharacter('\\', '/') + "\"\n";
             auto cc = "CC=" + Toolchain::dir.getChildFile("bin").getChildFile("gcc.exe").getFullPathName().replaceCharacter('\\', '/') + " ";
             auto cxx = "CXX=" + Toolchain::dir.getChildFile("bin").getChildFile("g++.exe").getFullPathName().replaceCharacter('\\', '/') + " ";
 
-            Toolchain::startShellScript(path + cc + cxx + make.getFullPathName().replaceCharacter('\\', '/') + " -j4 -f " + makefile.getFullPathName().replaceCharacter('\\', '/'), this);
+            Toolchain::startShellScript(path + cc + cxx + make.getFullPathName().replaceCharacter('\\', '/') + " " + getMakeJobsFlag() + " -f " + makefile.getFullPathName().replaceCharacter('\\', '/'), this);
 
 #else // Linux or BSD
             auto prepareEnvironmentScript = Toolchain::dir.getChildFile("scripts").getChildFile("anywhere-setup.sh").getFullPathName() + "\n";
 
             auto buildScript = prepareEnvironmentScript
                 + make.getFullPathName()
-                + " -j4 -f " + makefile.getFullPathName();
+                + " " + getMakeJobsFlag() + " -f " + makefile.getFullPathName();
 
             // For some reason we need to do this again
             outputFile.getChildFile("dpf").getChildFile("utils").getChildFile("generate-ttl.sh").setExecutePermission(true);
@@ -273,6 +284,9 @@ public:
 
             // Clean up if successful
             if (!compilationExitCode) {
+                exportingView->startExportStep("Updating cache");
+                cache.store();
+
                 outputFile.getChildFile("dpf").deleteRecursively();
                 outputFile.getChildFile("build").deleteRecursively();
                 outputFile.getChildFile("plugin").deleteRecursively();
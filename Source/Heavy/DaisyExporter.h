@@ -268,6 +268,8 @@ public:
 
         args.add(paths);
 
+        exportingView->startExportStep("Generating code");
+
         start(args.joinIntoString(" "));
         waitForProcessToFinish(-1);
         exportingView->flushConsole();
@@ -298,6 +300,15 @@ public:
             outputFile.getChildFile("hv").deleteRecursively();
             outputFile.getChildFile("c").deleteRecursively();
 
+            exportingView->startExportStep("Restoring cache");
+
+            ExportCache cache("Daisy", outputFile, name + "_" + board);
+            if (auto numUnchanged = cache.restore({ "daisy/source/build" }, args.joinIntoString(" ") + " " + compiler.getFullPathName())) {
+                exportingView->logToConsole("Reusing previous build: " + String(numUnchanged) + " of " + String(cache.getNumSourceFiles()) + " source files unchanged\n");
+            }
+
+            exportingView->startExportStep("Compiling");
+
             auto workingDir = File::getCurrentWorkingDirectory();
 
             sourceDir.setAsCurrentWorkingDirectory();
@@ -307,7 +318,7 @@ public:
 
 #if JUCE_WINDOWS
             auto buildScript = make.getFullPathName().replaceCharacter('\\', '/')
-                + " -j4 -f "
+                + " " + getMakeJobsFlag() + " -f "
                 + sourceDir.getChildFile("Makefile").getFullPathName().replaceCharacter('\\', '/')
                 + " GCC_PATH="
                 + gccPath.replaceCharacter('\\', '/')
@@ -316,7 +327,7 @@ public:
             Toolchain::startShellScript(buildScript, this);
 #else
             String buildScript = make.getFullPathName()
-                + " -j4 -f " + sourceDir.getChildFile("Makefile").getFullPathName()
+                + " " + getMakeJobsFlag() + " -f " + sourceDir.getChildFile("Makefile").getFullPathName()
                 + " GCC_PATH=" + gccPath
                 + " PROJECT_NAME=" + name;
 
@@ -334,6 +345,7 @@ public:
 
             auto compileExitCode = getExitCode();
             if (flash && !compileExitCode) {
+                exportingView->startExportStep("Flashing");
 
                 auto dfuUtil = bin.getChildFile("dfu-util" + exeSuffix);
 
@@ -415,12 +427,20 @@ public:
 
                 auto flashExitCode = getExitCode();
 
+                exportingView->startExportStep("Updating cache");
+                cache.store();
+
                 return heavyExitCode && flashExitCode;
             } else {
                 auto binLocation = outputFile.getChildFile(name + ".bin");
                 sourceDir.getChildFile("build").getChildFile("HeavyDaisy_" + name + ".bin").moveFileTo(binLocation);
             }
 
+            if (!compileExitCode) {
+                exportingView->startExportStep("Updating cache");
+                cache.store();
+            }
+
             outputFile.getChildFile("daisy").deleteRecursively();
             outputFile.getChildFile("libdaisy").deleteRecursively();
 
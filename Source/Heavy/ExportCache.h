@@ -0,0 +1,192 @@
+/*
+ // Copyright (c) 2022 Timothy Schoen and Wasted Audio
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <juce_cryptography/juce_cryptography.h>
+
+// Keeps the object files of the last successful build of an export, so that make only has to recompile what changed
+// Heavy regenerates all C code, and we copy the DPF and libDaisy sources again, on every export. That gives every source file a new
+// modification time, which would make make rebuild everything. To prevent that, we store a content hash of every source file next to
+// the cached object files. Source files with the same content get their old modification time back before building.
+// Object files depend on more than their sources: make doesn't rebuild them when the Makefile, the compiler flags or the export options
+// change. So the manifest also stores a hash of all of those, and the cache is thrown away if that doesn't match.
+class ExportCache {
+public:
+    ExportCache(String const& exporterName, File const& outputDir, String const& projectName)
+        : cacheDir(getCacheRoot().getChildFile(exporterName + "_" + String::toHexString((outputDir.getFullPathName() + "/" + projectName).hashCode64())))
+        , sourceDir(outputDir)
+    {
+    }
+
+    // Call this after generating the sources, and before building. Build directories are relative to the output directory
+    // The build configuration should contain everything that is passed to the generator and to make, like the export options and compiler flags
+    // Returns the number of source files that didn't change since the last build
+    int restore(StringArray const& buildDirectories, String const& buildConfiguration)
+    {
+        buildDirs = buildDirectories;
+        configurationHash = getConfigurationHash(buildConfiguration);
+        numSourceFiles = 0;
+        numUnchangedFiles = 0;
+
+        auto const manifestFile = cacheDir.getChildFile("manifest.xml");
+        auto const manifest = manifestFile.existsAsFile() ? ValueTree::fromXml(manifestFile.loadFileAsString()) : ValueTree();
+
+        // The manifest is only valid for the cached object files. If the previous build failed, there will still be object files in the output directory that we know nothing about
+        bool canRestore = manifest.isValid() && manifest.getProperty("Configuration").toString() == configurationHash;
+        for (auto const& dir : buildDirs) {
+            if (sourceDir.getChildFile(dir).exists())
+                canRestore = false;
+        }
+
+        std::unordered_map<String, std::pair<String, int64>> previousFiles;
+        if (canRestore) {
+            for (auto file : manifest) {
+                previousFiles[file.getProperty("Path").toString()] = { file.getProperty("Hash").toString(), static_cast<int64>(file.getProperty("Time")) };
+            }
+
+            for (auto const& dir : buildDirs) {
+                auto cachedBuildDir = cacheDir.getChildFile("build").getChildFile(dir);
+                if (cachedBuildDir.isDirectory()) {
+                    moveDirectory(cachedBuildDir, sourceDir.getChildFile(dir));
+                }
+            }
+        }
+
+        // Whatever happens, the cache is now used up: it gets refilled after a successful build
+        cacheDir.deleteRecursively();
+
+        for (auto const& file : findSourceFiles()) {
+            numSourceFiles++;
+
+            auto it = previousFiles.find(file.getRelativePathFrom(sourceDir));
+            if (it != previousFiles.end() && it->second.first == MD5(file).toHexString()) {
+                file.setLastModificationTime(Time(it->second.second));
+                numUnchangedFiles++;
+            }
+        }
+
+        return numUnchangedFiles;
+    }
+
+    // Call this after a successful build, before cleaning up the output directory
+    void store()
+    {
+        cacheDir.deleteRecursively();
+        if (!cacheDir.createDirectory())
+            return;
+
+        ValueTree manifest("Sources");
+        manifest.setProperty("Configuration", configurationHash, nullptr);
+        for (auto const& file : findSourceFiles()) {
+            ValueTree entry("File");
+            entry.setProperty("Path", file.getRelativePathFrom(sourceDir), nullptr);
+            entry.setProperty("Hash", MD5(file).toHexString(), nullptr);
+            entry.setProperty("Time", file.getLastModificationTime().toMilliseconds(), nullptr);
+            manifest.appendChild(entry, nullptr);
+        }
+
+        for (auto const& dir : buildDirs) {
+            auto buildDir = sourceDir.getChildFile(dir);
+            if (buildDir.isDirectory()) {
+                moveDirectory(buildDir, cacheDir.getChildFile("build").getChildFile(dir));
+            }
+        }
+
+        cacheDir.getChildFile("manifest.xml").replaceWithText(manifest.toXmlString());
+
+        pruneCaches();
+    }
+
+    int getNumSourceFiles() const
+    {
+        return numSourceFiles;
+    }
+
+    int getNumUnchangedFiles() const
+    {
+        return numUnchangedFiles;
+    }
+
+private:
+    static File getCacheRoot()
+    {
+        return ProjectInfo::appDataDir.getChildFile("Cache").getChildFile("Heavy");
+    }
+
+    // Every exported project gets its own cache, only keep the ones that were built most recently
+    static void pruneCaches()
+    {
+        auto caches = getCacheRoot().findChildFiles(File::findDirectories, false);
+        if (caches.size() <= maxNumCaches)
+            return;
+
+        auto getBuildTime = [](File const& cache) {
+            return cache.getChildFile("manifest.xml").getLastModificationTime();
+        };
+        std::sort(caches.begin(), caches.end(), [&getBuildTime](File const& a, File const& b) {
+            return getBuildTime(a) > getBuildTime(b);
+        });
+
+        for (int i = maxNumCaches; i < caches.size(); i++) {
+            caches[i].deleteRecursively();
+        }
+    }
+
+    // Hashes the build configuration together with every Makefile in the generated sources
+    String getConfigurationHash(String const& buildConfiguration) const
+    {
+        MemoryOutputStream configuration;
+        configuration << buildConfiguration;
+        for (auto const& file : findSourceFiles()) {
+            if (file.getFileName().startsWith("Makefile") || file.hasFileExtension("mk")) {
+                configuration << file.getRelativePathFrom(sourceDir) << MD5(file).toHexString();
+            }
+        }
+
+        return MD5(configuration.getMemoryBlock()).toHexString();
+    }
+
+    Array<File> findSourceFiles() const
+    {
+        Array<File> result;
+        for (auto const& entry : RangedDirectoryIterator(sourceDir, true, "*", File::findFiles)) {
+            auto const file = entry.getFile();
+
+            bool isBuildOutput = false;
+            for (auto const& dir : buildDirs) {
+                if (file.isAChildOf(sourceDir.getChildFile(dir))) {
+                    isBuildOutput = true;
+                    break;
+                }
+            }
+
+            if (!isBuildOutput)
+                result.add(file);
+        }
+
+        return result;
+    }
+
+    // The cache and the output directory can be on different volumes, in which case we can't just rename the directory
+    static void moveDirectory(File const& source, File const& destination)
+    {
+        destination.getParentDirectory().createDirectory();
+        if (!source.moveFileTo(destination) && source.copyDirectoryTo(destination)) {
+            source.deleteRecursively();
+        }
+    }
+
+    File cacheDir;
+    File sourceDir;
+    StringArray buildDirs;
+    String configurationHash;
+
+    static constexpr int maxNumCaches = 8;
+
+    int numSourceFiles = 0;
+    int numUnchangedFiles = 0;
+};
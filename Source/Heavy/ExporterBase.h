@@ -28,6 +28,12 @@ struct ExporterBase : public Component
 
     inline static File heavyExecutable = Toolchain::dir.getChildFile("bin").getChildFile("Heavy").getChildFile("Heavy" + exeSuffix);
 
+    // Use all cores for compiling the exported code
+    static String getMakeJobsFlag()
+    {
+        return "-j" + String(jmax(1, SystemStats::getNumCpus()));
+    }
+
     bool validPatchSelected = false;
 
     File patchFile;
@@ -169,6 +175,8 @@ struct ExporterBase : public Component
             if (shouldQuit)
                 return;
 
+            exportingView->logTimingReport();
+
             exportingView->showState(result ? ExportingProgressView::Failure : ExportingProgressView::Success);
 
             exportingView->stopMonitoring();
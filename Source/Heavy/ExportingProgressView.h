@@ -33,6 +33,12 @@ public:
     static constexpr int maxLength = 512;
     char processOutput[maxLength];
 
+    // Time spent on each step of the export, for the timing report
+    StringArray stepNames;
+    Array<double> stepDurations;
+    String currentStep;
+    double currentStepStart = 0.0;
+
     ExportingProgressView()
         : Thread("Console thread")
     {
@@ -118,6 +124,48 @@ public:
         });
     }
 
+    // Only call these from the exporting thread
+    void startExportStep(String const& name)
+    {
+        finishExportStep();
+        currentStep = name;
+        currentStepStart = Time::getMillisecondCounterHiRes();
+    }
+
+    void finishExportStep()
+    {
+        if (currentStep.isNotEmpty()) {
+            stepNames.add(currentStep);
+            stepDurations.add(Time::getMillisecondCounterHiRes() - currentStepStart);
+            currentStep = String();
+        }
+    }
+
+    void logTimingReport()
+    {
+        finishExportStep();
+
+        if (stepNames.isEmpty())
+            return;
+
+        auto formatDuration = [](double ms) {
+            return ms < 1000.0 ? String(roundToInt(ms)) + " ms" : String(ms / 1000.0, 1) + " s";
+        };
+
+        String report = "\nExport timing:\n";
+        double total = 0.0;
+        for (int i = 0; i < stepNames.size(); i++) {
+            report += "  " + stepNames[i].paddedRight(' ', 20) + formatDuration(stepDurations[i]) + "\n";
+            total += stepDurations[i];
+        }
+        report += "  " + String("Total").paddedRight(' ', 20) + formatDuration(total) + "\n";
+
+        logToConsole(report);
+
+        stepNames.clear();
+        stepDurations.clear();
+    }
+
     void logToConsole(String const& text)
     {
 
@@ -17,6 +17,7 @@
 
 #include "Toolchain.h"
 #include "ExportingProgressView.h"
+#include "ExportCache.h"
 #include "ExporterBase.h"
 #include "CppExporter.h"
 #include "DPFExporter.h"
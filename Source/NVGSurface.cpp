@@ -18,6 +18,7 @@ using namespace juce::gl;
 
 #include "PluginEditor.h"
 #include "PluginProcessor.h"
+#include "Utility/CachedTextRender.h"
 
 #define ENABLE_FPS_COUNT 0
 
@@ -149,6 +150,7 @@ void NVGSurface::detachContext()
     if (makeContextActive()) {
         NVGFramebuffer::clearAll(nvg);
         NVGImage::clearAll(nvg);
+        TextAtlas::releaseContext(nvg);
 
         if (invalidFBO) {
             nvgDeleteFramebuffer(invalidFBO);
@@ -344,6 +346,7 @@ void NVGSurface::render()
         nvgScale(nvg, desktopScale, desktopScale);
         nvgScissor(nvg, invalidArea.getX(), invalidArea.getY(), invalidArea.getWidth(), invalidArea.getHeight());
         editor->renderArea(nvg, invalidArea);
+        TextAtlas::uploadPendingChanges(nvg);
         nvgEndFrame(nvg);
 
         nvgBindFramebuffer(mainFBO);
@@ -462,3 +462,90 @@ struct NVGScopedState
     
     NVGcontext* nvg;
 };
+
+// What NanoVG handed to the backend. Every fill, stroke and batch of triangles becomes at least one draw call when the frame is flushed
+struct NVGRenderStatistics {
+    int numFills = 0;
+    int numStrokes = 0;
+    int numTriangles = 0;
+
+    int getNumDrawCalls() const
+    {
+        return numFills + numStrokes + numTriangles;
+    }
+};
+
+// Counts the draw calls of everything rendered while it exists, by putting counting functions in front of the backend's render functions
+// The counting functions take their signature from NVGparams, so they keep working if the backend interface changes
+// Counters can be nested, the innermost one gets the counts
+class NVGDrawCallCounter {
+public:
+    NVGDrawCallCounter(NVGcontext* nvg, NVGRenderStatistics& target)
+        : params(nvgInternalParams(nvg))
+        , statistics(target)
+        , previous(current)
+    {
+        install<Fill>(params->renderFill);
+        install<Stroke>(params->renderStroke);
+        install<Triangles>(params->renderTriangles);
+        current = this;
+    }
+
+    ~NVGDrawCallCounter()
+    {
+        current = previous;
+        if (!previous) {
+            uninstall<Fill>(params->renderFill);
+            uninstall<Stroke>(params->renderStroke);
+            uninstall<Triangles>(params->renderTriangles);
+        }
+    }
+
+private:
+    enum CallType {
+        Fill,
+        Stroke,
+        Triangles
+    };
+
+    template<int Type, typename Function>
+    struct CountingCall;
+
+    template<int Type, typename Result, typename... Args>
+    struct CountingCall<Type, Result (*)(Args...)> {
+        static inline Result (*original)(Args...) = nullptr;
+
+        static Result call(Args... args)
+        {
+            if (current) {
+                auto& statistics = current->statistics;
+                (Type == Fill ? statistics.numFills : Type == Stroke ? statistics.numStrokes : statistics.numTriangles)++;
+            }
+            return original(args...);
+        }
+    };
+
+    template<int Type, typename Function>
+    static void install(Function& function)
+    {
+        using Call = CountingCall<Type, Function>;
+        if (function != &Call::call) {
+            Call::original = function;
+            function = &Call::call;
+        }
+    }
+
+    template<int Type, typename Function>
+    static void uninstall(Function& function)
+    {
+        using Call = CountingCall<Type, Function>;
+        if (function == &Call::call)
+            function = Call::original;
+    }
+
+    NVGparams* params;
+    NVGRenderStatistics& statistics;
+    NVGDrawCallCounter* previous;
+
+    static inline NVGDrawCallCounter* current = nullptr;
+};
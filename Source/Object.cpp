@@ -75,6 +75,7 @@ Object::~Object()
 {
     hideEditor(); // Make sure the editor is not still open, that could lead to issues with listeners attached to the editor (i.e. suggestioncomponent)
     cnv->selectedComponents.removeChangeListener(this);
+    cnv->objectSpatialIndex.remove(this);
 }
 
 void Object::updateObjectActivityPolicy(String objectName)
@@ -452,7 +453,7 @@ void Object::setType(String const& newType, pd::WeakReference existingObject)
     editor->updateCommandStatus();
 
     cnv->synchroniseSplitCanvas();
-    cnv->pd->updateObjectImplementations();
+    cnv->pd->updateObjectImplementations(cnv->patch.getUncheckedPointer());
 }
 
 Array<Rectangle<float>> Object::getCorners() const
@@ -524,6 +525,23 @@ void Object::resized()
     }
 
     updateIoletGeometry();
+    updateSpatialIndex();
+}
+
+void Object::moved()
+{
+    updateSpatialIndex();
+}
+
+// Labels can be outside of the object, so they're included in the area that the canvas finds this object in
+void Object::updateSpatialIndex()
+{
+    auto bounds = getBounds();
+    if (gui && gui->labels && gui->labels->isVisible()) {
+        bounds = bounds.getUnion(gui->labels->getBounds());
+    }
+
+    cnv->objectSpatialIndex.update(this, bounds);
 }
 
 void Object::updateIoletGeometry()
@@ -936,7 +954,7 @@ void Object::mouseUp(MouseEvent const& e)
         cnv->patch.endUndoSequence("Drag");
     }
 
-    cnv->needsSearchUpdate = true;
+    cnv->invalidateSearchTrees();
 }
 
 void Object::mouseDrag(MouseEvent const& e)
@@ -1178,7 +1196,7 @@ void Object::mouseDrag(MouseEvent const& e)
             auto* object = selection.getFirst();
             if (object->numInputs && object->numOutputs && !object->iolets.isEmpty()) {
                 bool intersected = false;
-                for (auto* connection : cnv->connections) {
+                for (auto* connection : cnv->connectionSpatialIndex.query(object->iolets[0]->getCanvasBounds())) {
 
                     if (connection->intersectsRectangle(object->iolets[0]->getCanvasBounds())) {
                         object->iolets[0]->isTargeted = true;
@@ -1232,6 +1250,15 @@ void Object::render(NVGcontext* nvg)
         nvgSmoothGlow(nvg, lb.getX(), lb.getY(), lb.getWidth(), lb.getHeight(), glowColour, nvgRGBA(0, 0, 0, 0), Corners::objectCornerRadius, 1.1f);
     }
 
+    if (cnv->shouldShowDSPLoad()) {
+        auto const load = cnv->pd->dspProfiler->getLoad(getPointer());
+        if (load > 0.0f) {
+            // Goes from yellow to red as the share of the DSP load increases
+            auto heatColour = Colours::yellow.interpolatedWith(Colours::red, jmin(1.0f, load * 2.0f)).withAlpha(jmap(jmin(1.0f, load * 4.0f), 0.2f, 0.9f));
+            nvgSmoothGlow(nvg, lb.getX(), lb.getY(), lb.getWidth(), lb.getHeight(), convertColour(heatColour), nvgRGBA(0, 0, 0, 0), Corners::objectCornerRadius, 1.1f);
+        }
+    }
+
     if (gui && gui->isTransparent() && !getValue<bool>(locked) && !cnv->isGraph) {
         nvgFillColor(nvg, convertColour(getLookAndFeel().findColour(PlugDataColour::canvasBackgroundColourId).contrasting(0.35f).withAlpha(0.1f)));
         nvgFillRoundedRect(nvg, b.getX(), b.getY(), b.getWidth(), b.getHeight(), Corners::objectCornerRadius);
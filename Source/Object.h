@@ -52,8 +52,10 @@ public:
     void timerCallback() override;
 
     void resized() override;
+    void moved() override;
 
     void updateIoletGeometry();
+    void updateSpatialIndex();
 
     bool keyPressed(KeyPress const& key, Component* component) override;
 
@@ -109,6 +111,9 @@ public:
     int numInputs = 0;
     int numOutputs = 0;
 
+    // Summary of the pd state that was read at the last synchronise, so unchanged objects can be skipped
+    uint64 syncSignature = 0;
+
     Value locked;
     Value commandLocked;
     Value presentationMode;
@@ -5,6 +5,7 @@
  */
 
 #include "Components/PropertiesPanel.h"
+#include "Utility/MinMaxPyramid.h"
 
 extern "C" {
 void garray_arraydialog(t_fake_garray* x, t_symbol* name, t_floatarg fsize, t_floatarg fflags, t_floatarg deleteit);
@@ -41,6 +42,7 @@ public:
     {
         vec.reserve(8192);
         read(vec);
+        pyramid.rebuild(vec.data(), vec.size());
 
         updateParameters();
 
@@ -60,42 +62,64 @@ public:
         pd->unregisterMessageListener(arr.getRawUnchecked<void>(), this);
     }
 
-    static std::vector<float> rescale(std::vector<float> const& v, unsigned const newSize)
+    // Draws the min/max range of the values in every pixel column, connected by a zigzag line, like a waveform display
+    static Path createEnvelopePath(std::vector<float> const& values, MinMaxPyramid const& pyramid, std::array<float, 2> scale, bool invert, float width, float height)
     {
-        if (v.empty()) {
-            return {};
-        }
+        float const dh = height / (scale[1] - scale[0]);
+        float const invh = invert ? 0 : height;
+        float const yscale = invert ? -1.0f : 1.0f;
+
+        auto toY = [&](float value) {
+            return invh - (std::clamp(value, scale[0], scale[1]) - scale[0]) * dh * yscale;
+        };
 
-        std::vector<float> result(newSize);
-        std::size_t const oldSize = v.size();
-        for (unsigned i = 0; i < newSize; i++) {
-            auto const idx = i * (oldSize - 1) / newSize;
-            auto const mod = i * (oldSize - 1) % newSize;
+        auto const numColumns = std::max<size_t>(1, static_cast<size_t>(width));
+        auto const numValues = values.size();
 
-            if (mod == 0)
-                result[i] = v[idx];
-            else {
-                float const part = float(mod) / float(newSize);
-                result[i] = v[idx] * (1.0 - part) + v[idx + 1] * part;
+        Path result;
+        bool isNewPath = true;
+        for (size_t column = 0; column < numColumns; column++) {
+            auto const start = column * numValues / numColumns;
+            auto const end = std::max(start + 1, (column + 1) * numValues / numColumns);
+            auto const range = pyramid.getMinMax(values.data(), start, end);
+
+            auto const x = (static_cast<float>(column) + 0.5f) * width / static_cast<float>(numColumns);
+            auto const first = Point<float>(x, toY(column % 2 ? range.max : range.min));
+            auto const second = Point<float>(x, toY(column % 2 ? range.min : range.max));
+
+            if (range.isEmpty() || !first.isFinite() || !second.isFinite()) {
+                isNewPath = true;
+                continue;
             }
+
+            if (isNewPath) {
+                result.startNewSubPath(first);
+                isNewPath = false;
+            } else {
+                result.lineTo(first);
+            }
+            result.lineTo(second);
         }
+
         return result;
     }
-        
-    static Path createArrayPath(std::vector<float> points, DrawType style, std::array<float, 2> scale, float width, float height)
+
+    static Path createArrayPath(std::vector<float> const& values, MinMaxPyramid const& pyramid, DrawType style, std::array<float, 2> scale, float width, float height)
     {
         bool invert = false;
         if (scale[0] >= scale[1]) {
             invert = true;
             std::swap(scale[0], scale[1]);
         }
-        
+
         // More than a point per pixel will cause insane loads, and isn't actually helpful
-        // Instead, linearly interpolate the vector to a max size of width in pixels
-        if (points.size() > width) {
-            points = rescale(points, width);
+        // Instead, draw the min/max envelope of the values in every pixel, so we don't lose any peaks
+        if (values.size() > width) {
+            return createEnvelopePath(values, pyramid, scale, invert, width, height);
         }
-        
+
+        auto points = values;
+
         // Need at least 4 points to draw a bezier curve
         if(points.size() <= 4 && style == Curve) style = Polygon;
         
@@ -195,15 +219,41 @@ public:
         return result;
     }
 
+    // The path only needs to be rebuilt when the values, size or drawing settings changed
+    Path const& getArrayPath(float width, float height)
+    {
+        auto const drawType = getDrawType();
+        auto const scale = getScale();
+        if (needsNewPath || cachedPathSize != Point<float>(width, height) || cachedPathDrawType != drawType || cachedPathScale != scale) {
+            cachedPath = createArrayPath(vec, pyramid, drawType, scale, width, height);
+            cachedPathSize = { width, height };
+            cachedPathDrawType = drawType;
+            cachedPathScale = scale;
+            needsNewPath = false;
+        }
+
+        return cachedPath;
+    }
+
+    // Updates the min/max pyramid for a range of values that changed
+    void valuesChanged(Range<int> changedRange)
+    {
+        if (pyramid.getNumValues() != vec.size()) {
+            pyramid.rebuild(vec.data(), vec.size());
+        } else {
+            pyramid.update(vec.data(), changedRange.getStart(), changedRange.getEnd());
+        }
+        needsNewPath = true;
+    }
+
     void paintGraph(Graphics& g)
     {
         auto const h = static_cast<float>(getHeight());
         auto const w = static_cast<float>(getWidth());
 
         if (!vec.empty()) {
-            auto p = createArrayPath(vec, getDrawType(), getScale(), w, h);
             g.setColour(getContentColour());
-            g.strokePath(p, PathStrokeType(getLineWidth()));
+            g.strokePath(getArrayPath(w, h), PathStrokeType(getLineWidth()));
         }
     }
 
@@ -216,8 +266,7 @@ public:
         nvgIntersectRoundedScissor(nvg, arrB.getX(), arrB.getY(), arrB.getWidth(), arrB.getHeight(), Corners::objectCornerRadius);
         
         if (!vec.empty()) {
-            auto p = createArrayPath(vec, getDrawType(), getScale(), w, h);
-            setJUCEPath(nvg, p);
+            setJUCEPath(nvg, getArrayPath(w, h));
             
             nvgStrokeColor(nvg, nvgRGBAf(getContentColour().getFloatRed(), getContentColour().getFloatGreen(), getContentColour().getFloatBlue(), getContentColour().getFloatAlpha()));
             nvgStrokeWidth(nvg, getLineWidth());
@@ -384,6 +433,8 @@ public:
             vec[n] = jmap<float>(n, interpStart, interpEnd + 1, min, max);
         }
 
+        valuesChanged({ interpStart, interpEnd + 1 });
+
         // Don't want to touch vec on the other thread, so we copy the vector into the lambda
         auto changed = std::vector<float>(vec.begin() + interpStart, vec.begin() + interpEnd + 1);
 
@@ -419,8 +470,11 @@ public:
         size = getArraySize();
 
         if (!edited) {
-            bool changed = read(vec);
-            if(changed) repaint();
+            auto changedRange = read(vec);
+            if (!changedRange.isEmpty()) {
+                valuesChanged(changedRange);
+                repaint();
+            }
         }
     }
 
@@ -618,22 +672,31 @@ public:
         }
     }
 
-    // Gets the values from the array.
-    bool read(std::vector<float>& output) const
+    // Gets the values from the array, and returns the range of values that changed
+    Range<int> read(std::vector<float>& output) const
     {
-        bool changed = false;
+        int firstChanged = -1;
+        int lastChanged = -1;
         if (auto ptr = arr.get<t_garray>()) {
             int const size = garray_getarray(ptr.get())->a_n;
-            output.resize(static_cast<size_t>(size));
+            if (output.size() != static_cast<size_t>(size)) {
+                output.resize(static_cast<size_t>(size));
+                firstChanged = 0;
+                lastChanged = size - 1;
+            }
 
             t_word* vec = ((t_word*)garray_vec(ptr.get()));
             for (int i = 0; i < size; i++) {
-                changed = changed || output[i] != vec[i].w_float;
-                output[i] = vec[i].w_float;
+                if (output[i] != vec[i].w_float) {
+                    if (firstChanged < 0)
+                        firstChanged = i;
+                    lastChanged = std::max(lastChanged, i);
+                    output[i] = vec[i].w_float;
+                }
             }
         }
-        
-        return changed;
+
+        return firstChanged < 0 ? Range<int>() : Range<int>(firstChanged, lastChanged + 1);
     }
 
     // Writes a value to the array.
@@ -648,6 +711,14 @@ public:
     pd::WeakReference arr;
 
     std::vector<float> vec;
+    MinMaxPyramid pyramid;
+
+    Path cachedPath;
+    Point<float> cachedPathSize;
+    DrawType cachedPathDrawType = Points;
+    std::array<float, 2> cachedPathScale = { 0.0f, 0.0f };
+    bool needsNewPath = true;
+
     std::atomic<bool> edited;
     bool error = false;
     String const stringArray = "array";
@@ -1192,6 +1263,8 @@ public:
         } else {
             labels.reset(nullptr);
         }
+
+        object->updateSpatialIndex();
     }
 
     Rectangle<int> getPdBounds() override
@@ -340,6 +340,8 @@ public:
         } else {
             labels.reset(nullptr);
         }
+
+        object->updateSpatialIndex();
     }
 
     float getFontHeight() const
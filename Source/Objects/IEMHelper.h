@@ -309,6 +309,8 @@ public:
                 labels->setVisible(false);
             labels.reset(nullptr);
         }
+
+        object->updateSpatialIndex();
     }
 
     Rectangle<int> getLabelBounds()
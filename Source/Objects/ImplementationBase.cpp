@@ -178,75 +178,109 @@ ObjectImplementationManager::ObjectImplementationManager(pd::Instance* processor
 
 void ObjectImplementationManager::handleAsyncUpdate()
 {
-    Array<std::pair<t_canvas*, t_gobj*>> allImplementations;
-
     pd->setThis();
 
-    pd->lockAudioThread();
-    for (auto* cnv = pd_getcanvaslist(); cnv; cnv = cnv->gl_next) {
-        for (auto* object : getImplementationsForPatch(cnv)) {
-            allImplementations.add({ cnv, object });
-        }
-    }
-    pd->unlockAudioThread();
+    // If the patch that contained a deleted object is also gone, a subpatch or abstraction was deleted or reloaded
+    // That also happens in patches that aren't open in the editor, for example when pd reloads all instances of an abstraction after it was saved
+    bool const fullUpdate = removeDeletedImplementations() || needsFullUpdate;
 
-    // Remove unused object implementations
-    for (auto it = objectImplementations.cbegin(); it != objectImplementations.cend();) {
-        auto& [ptr, implementation] = *it;
+    std::vector<FoundImplementation> found;
 
-        auto found = std::find_if(allImplementations.begin(), allImplementations.end(), [ptr = ptr](auto const& toCompare) {
-            return std::get<1>(toCompare) == ptr;
-        });
+    pd->lockAudioThread();
+    if (fullUpdate) {
+        for (auto* cnv = pd_getcanvaslist(); cnv; cnv = cnv->gl_next) {
+            findImplementations(cnv, cnv, found);
+        }
+    } else {
+        for (auto const& changedPatch : changedPatches) {
+            if (auto* patch = changedPatch.getRaw<t_canvas>()) {
+                auto* root = patch;
+                while (root->gl_owner)
+                    root = root->gl_owner;
 
-        if (found == allImplementations.end()) {
-            objectImplementations.erase(it++);
-        } else {
-            it++;
+                findImplementations(root, patch, found);
+            }
         }
     }
+    pd->unlockAudioThread();
 
-    for (auto& [cnv, obj] : allImplementations) {
-        if (!objectImplementations.count(obj)) {
+    changedPatches.clear();
+    needsFullUpdate = false;
 
+    for (auto& [root, owner, obj] : found) {
+        auto it = objectImplementations.find(obj);
+        if (it == objectImplementations.end()) {
             auto const name = String::fromUTF8(pd::Interface::getObjectClassName(&obj->g_pd));
 
-            objectImplementations[obj] = std::unique_ptr<ImplementationBase>(ImplementationBase::createImplementation(name, obj, cnv, pd));
+            it = objectImplementations.emplace(obj, Implementation { std::unique_ptr<ImplementationBase>(ImplementationBase::createImplementation(name, obj, root, pd)), pd::WeakReference(owner, pd) }).first;
         }
 
-        objectImplementations[obj]->update();
+        if (auto& implementation = it->second.implementation)
+            implementation->update();
     }
 }
 
+// Returns true if an implementation was removed together with the patch it was in
+bool ObjectImplementationManager::removeDeletedImplementations()
+{
+    bool ownerWasDeleted = false;
+    for (auto it = objectImplementations.begin(); it != objectImplementations.end();) {
+        auto const& [implementation, owner] = it->second;
+        if (!implementation || !implementation->ptr.isValid()) {
+            ownerWasDeleted = ownerWasDeleted || !owner.isValid();
+            it = objectImplementations.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    return ownerWasDeleted;
+}
+
 void ObjectImplementationManager::updateObjectImplementations()
 {
+    needsFullUpdate = true;
     triggerAsyncUpdate();
 }
 
-Array<t_gobj*> ObjectImplementationManager::getImplementationsForPatch(t_canvas* patch)
+void ObjectImplementationManager::updateObjectImplementations(t_canvas* changedPatch)
 {
-    Array<t_gobj*> implementations;
+    auto patch = pd::WeakReference(changedPatch, pd);
+    if (std::find(changedPatches.begin(), changedPatches.end(), patch) == changedPatches.end()) {
+        changedPatches.push_back(patch);
+    }
 
+    triggerAsyncUpdate();
+}
+
+void ObjectImplementationManager::findImplementations(t_canvas* root, t_canvas* patch, std::vector<FoundImplementation>& result)
+{
     auto* glist = static_cast<t_glist*>(patch);
     for (t_gobj* y = glist->gl_list; y; y = y->g_next) {
 
         auto const* name = pd::Interface::getObjectClassName(&y->g_pd);
 
         if (pd_class(&y->g_pd) == canvas_class) {
-            implementations.addArray(getImplementationsForPatch(reinterpret_cast<t_canvas*>(y)));
+            findImplementations(root, reinterpret_cast<t_canvas*>(y), result);
         }
         if (pd_class(&y->g_pd) == clone_class) {
+            // All instances of a clone are copies of the same abstraction
+            // So if the first instance doesn't contain anything that needs an implementation, we can skip the others
+            bool instancesNeedScanning = true;
             for (int i = 0; i < clone_get_n(y); i++) {
                 auto* clone = clone_get_instance(y, i);
-                implementations.addArray(getImplementationsForPatch(clone));
-                implementations.add(&clone->gl_obj.te_g);
+                if (instancesNeedScanning) {
+                    auto const numFound = result.size();
+                    findImplementations(root, clone, result);
+                    instancesNeedScanning = result.size() > numFound;
+                }
+                result.push_back({ root, patch, &clone->gl_obj.te_g });
             }
         }
         if (ImplementationBase::hasImplementation(name)) {
-            implementations.add(y);
+            result.push_back({ root, patch, y });
         }
     }
-
-    return implementations;
 }
 
 void ObjectImplementationManager::clearObjectImplementationsForPatch(t_canvas* patch)
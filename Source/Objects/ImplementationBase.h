@@ -37,19 +37,42 @@ public:
     JUCE_DECLARE_WEAK_REFERENCEABLE(ImplementationBase)
 };
 
+// Creates and removes implementations for the objects in all patches that need them
+// Instead of comparing a scan of all patches against the existing implementations after every change, we drop implementations as soon
+// as pd frees their object (which their weak reference tells us), and only rescan the patches that were changed.
 class ObjectImplementationManager : public AsyncUpdater {
 public:
     explicit ObjectImplementationManager(pd::Instance* pd);
 
+    // Rescans all patches, and updates all implementations
     void updateObjectImplementations();
+
+    // Only rescans the patch that changed, and the subpatches and clones inside it
+    void updateObjectImplementations(t_canvas* changedPatch);
+
     void clearObjectImplementationsForPatch(t_canvas* patch);
 
     void handleAsyncUpdate() override;
 
 private:
-    Array<t_gobj*> getImplementationsForPatch(t_canvas* patch);
+    struct FoundImplementation {
+        t_canvas* root;
+        t_canvas* owner;
+        t_gobj* object;
+    };
+
+    struct Implementation {
+        std::unique_ptr<ImplementationBase> implementation;
+        pd::WeakReference owner;
+    };
+
+    void findImplementations(t_canvas* root, t_canvas* patch, std::vector<FoundImplementation>& result);
+    bool removeDeletedImplementations();
 
     PluginProcessor* pd;
 
-    std::map<t_gobj*, std::unique_ptr<ImplementationBase>> objectImplementations;
+    std::unordered_map<t_gobj*, Implementation> objectImplementations;
+
+    std::vector<pd::WeakReference> changedPatches;
+    bool needsFullUpdate = true;
 };
@@ -72,51 +72,37 @@ struct pd::Instance::internal {
 
     static void instance_multi_noteon(pd::Instance* ptr, int channel, int pitch, int velocity)
     {
-        ptr->enqueueFunctionAsync([ptr, channel, pitch, velocity]() mutable {
-            ptr->receiveNoteOn(channel + 1, pitch, velocity);
-        });
+        ptr->enqueueMidiEvent(MidiEvent::NoteOn, channel, pitch, velocity);
     }
 
     static void instance_multi_controlchange(pd::Instance* ptr, int channel, int controller, int value)
     {
-        ptr->enqueueFunctionAsync([ptr, channel, controller, value]() mutable {
-            ptr->receiveControlChange(channel + 1, controller, value);
-        });
+        ptr->enqueueMidiEvent(MidiEvent::ControlChange, channel, controller, value);
     }
 
     static void instance_multi_programchange(pd::Instance* ptr, int channel, int value)
     {
-        ptr->enqueueFunctionAsync([ptr, channel, value]() mutable {
-            ptr->receiveProgramChange(channel + 1, value);
-        });
+        ptr->enqueueMidiEvent(MidiEvent::ProgramChange, channel, value, 0);
     }
 
     static void instance_multi_pitchbend(pd::Instance* ptr, int channel, int value)
     {
-        ptr->enqueueFunctionAsync([ptr, channel, value]() mutable {
-            ptr->receivePitchBend(channel + 1, value);
-        });
+        ptr->enqueueMidiEvent(MidiEvent::PitchBend, channel, value, 0);
     }
 
     static void instance_multi_aftertouch(pd::Instance* ptr, int channel, int value)
     {
-        ptr->enqueueFunctionAsync([ptr, channel, value]() mutable {
-            ptr->receiveAftertouch(channel + 1, value);
-        });
+        ptr->enqueueMidiEvent(MidiEvent::AfterTouch, channel, value, 0);
     }
 
     static void instance_multi_polyaftertouch(pd::Instance* ptr, int channel, int pitch, int value)
     {
-        ptr->enqueueFunctionAsync([ptr, channel, pitch, value]() mutable {
-            ptr->receivePolyAftertouch(channel + 1, pitch, value);
-        });
+        ptr->enqueueMidiEvent(MidiEvent::PolyAfterTouch, channel, pitch, value);
     }
 
     static void instance_multi_midibyte(pd::Instance* ptr, int port, int byte)
     {
-        ptr->enqueueFunctionAsync([ptr, port, byte]() mutable {
-            ptr->receiveMidiByte(port + 1, byte);
-        });
+        ptr->enqueueMidiEvent(MidiEvent::MidiByte, port, byte, 0);
     }
 
     static void instance_multi_print(pd::Instance* ptr, void* object, char const* s)
@@ -134,11 +120,13 @@ Instance::Instance()
 {
     pd::Setup::initialisePd();
     objectImplementations = std::make_unique<::ObjectImplementationManager>(this);
+    dspProfiler = std::make_unique<DSPProfiler>(this);
 }
 
 Instance::~Instance()
 {
     objectImplementations.reset(nullptr); // Make sure it gets deallocated before pd instance gets deleted
+    dspProfiler.reset(nullptr);
     
     pd_free(static_cast<t_pd*>(messageReceiver));
     pd_free(static_cast<t_pd*>(midiReceiver));
@@ -175,20 +163,18 @@ void Instance::initialisePd(String& pdlua_version)
 
     setup_weakreferences(
         [](void* instance, void* ref) {
-            static_cast<pd::Instance*>(instance)->clearWeakReferences(ref);
+            static_cast<pd::Instance*>(instance)->weakReferences.clear(ref);
         },
         [](void* instance, void* ref, void* weakref) {
-            auto** reference_state = reinterpret_cast<pd_weak_reference**>(weakref);
-            *reference_state = new pd_weak_reference(true);
-            static_cast<pd::Instance*>(instance)->registerWeakReference(ref, *reference_state);
+            auto** reference_state = reinterpret_cast<WeakReferenceTable::ExternalReference**>(weakref);
+            *reference_state = static_cast<pd::Instance*>(instance)->weakReferences.createExternalReference(ref);
         },
         [](void* instance, void* ref, void* weakref) {
-            auto** reference_state = reinterpret_cast<pd_weak_reference**>(weakref);
-            static_cast<pd::Instance*>(instance)->unregisterWeakReference(ref, *reference_state);
+            auto** reference_state = reinterpret_cast<WeakReferenceTable::ExternalReference**>(weakref);
             delete *reference_state;
         },
         [](void* ref) -> int {
-            return ((pd_weak_reference*)ref)->load();
+            return static_cast<WeakReferenceTable::ExternalReference*>(ref)->isAlive();
         });
 
     midiReceiver = pd::Setup::createMIDIHook(this, reinterpret_cast<t_plugdata_noteonhook>(internal::instance_multi_noteon), reinterpret_cast<t_plugdata_controlchangehook>(internal::instance_multi_controlchange), reinterpret_cast<t_plugdata_programchangehook>(internal::instance_multi_programchange),
@@ -360,6 +346,7 @@ void Instance::releaseDSP()
 void Instance::performDSP(float const* inputs, float* outputs)
 {
     libpd_set_instance(static_cast<t_pdinstance*>(instance));
+    DSPProfiler::ScopedBlock profilerBlock(dspProfiler.get());
     libpd_process_raw(inputs, outputs);
 }
 
@@ -445,17 +432,45 @@ void Instance::sendSymbol(char const* receiver, char const* symbol) const
     libpd_symbol(receiver, symbol);
 }
 
+// Converts a list of pd::Atoms to t_atoms, using stack storage for typical message lengths so we don't allocate while sending
+class AtomBuffer {
+public:
+    explicit AtomBuffer(std::vector<Atom> const& list)
+        : size(static_cast<int>(list.size()))
+    {
+        if (list.size() > numStackAtoms) {
+            heapAtoms.malloc(list.size());
+            atoms = heapAtoms.get();
+        }
+
+        for (size_t i = 0; i < list.size(); ++i) {
+            if (list[i].isSymbol())
+                SETSYMBOL(atoms + i, list[i].getSymbol());
+            else
+                SETFLOAT(atoms + i, list[i].getFloat());
+        }
+    }
+
+    t_atom* data() { return atoms; }
+    int getSize() const { return size; }
+
+private:
+    static constexpr size_t numStackAtoms = 64;
+
+    t_atom stackAtoms[numStackAtoms];
+    HeapBlock<t_atom> heapAtoms;
+    t_atom* atoms = stackAtoms;
+    int size;
+
+    JUCE_DECLARE_NON_COPYABLE(AtomBuffer)
+};
+
 void Instance::sendList(char const* receiver, std::vector<Atom> const& list) const
 {
-    auto argv = std::vector<t_atom>(list.size());
     libpd_set_instance(static_cast<t_pdinstance*>(instance));
-    for (size_t i = 0; i < list.size(); ++i) {
-        if (list[i].isFloat())
-            libpd_set_float(argv.data() + i, list[i].getFloat());
-        else
-            libpd_set_symbol(argv.data() + i, list[i].getSymbol()->s_name);
-    }
-    libpd_list(receiver, static_cast<int>(list.size()), argv.data());
+
+    AtomBuffer argv(list);
+    libpd_list(receiver, argv.getSize(), argv.data());
 }
 
 void Instance::sendTypedMessage(void* object, char const* msg, std::vector<Atom> const& list) const
@@ -465,16 +480,8 @@ void Instance::sendTypedMessage(void* object, char const* msg, std::vector<Atom>
 
     libpd_set_instance(static_cast<t_pdinstance*>(instance));
 
-    auto argv = std::vector<t_atom>(list.size());
-
-    for (size_t i = 0; i < list.size(); ++i) {
-        if (list[i].isFloat())
-            libpd_set_float(argv.data() + i, list[i].getFloat());
-        else
-            libpd_set_symbol(argv.data() + i, list[i].getSymbol()->s_name);
-    }
-
-    pd_typedmess(static_cast<t_pd*>(object), generateSymbol(msg), static_cast<int>(list.size()), argv.data());
+    AtomBuffer argv(list);
+    pd_typedmess(static_cast<t_pd*>(object), generateSymbol(msg), argv.getSize(), argv.data());
 }
 
 void Instance::sendMessage(char const* receiver, char const* msg, std::vector<Atom> const& list) const
@@ -482,20 +489,12 @@ void Instance::sendMessage(char const* receiver, char const* msg, std::vector<At
     sendTypedMessage(generateSymbol(receiver)->s_thing, msg, list);
 }
 
-void Instance::processSend(dmessage mess)
+void Instance::processSend(dmessage const& mess)
 {
     if (auto obj = mess.object.get<t_pd>()) {
         if (mess.selector == "list") {
-            auto argv = std::vector<t_atom>(mess.list.size());
-            for (size_t i = 0; i < mess.list.size(); ++i) {
-                if (mess.list[i].isFloat())
-                    SETFLOAT(argv.data() + i, mess.list[i].getFloat());
-                else if (mess.list[i].isSymbol()) {
-                    SETSYMBOL(argv.data() + i, mess.list[i].getSymbol());
-                } else
-                    SETFLOAT(argv.data() + i, 0.0);
-            }
-            pd_list(obj.get(), generateSymbol("list"), static_cast<int>(mess.list.size()), argv.data());
+            AtomBuffer argv(mess.list);
+            pd_list(obj.get(), generateSymbol("list"), argv.getSize(), argv.data());
         } else if (mess.selector == "float" && !mess.list.empty() && mess.list[0].isFloat()) {
             pd_float(obj.get(), mess.list[0].getFloat());
         } else if (mess.selector == "symbol" && !mess.list.empty() && mess.list[0].isSymbol()) {
@@ -518,41 +517,21 @@ void Instance::unregisterMessageListener(void* object, MessageListener* messageL
     messageDispatcher->removeMessageListener(object, messageListener);
 }
 
-void Instance::registerWeakReference(void* ptr, pd_weak_reference* ref)
-{
-    weakReferenceMutex.lock();
-    pdWeakReferences[ptr].push_back(ref);
-    weakReferenceMutex.unlock();
-}
-
-void Instance::unregisterWeakReference(void* ptr, pd_weak_reference const* ref)
+void Instance::enqueueFunctionAsync(std::function<void(void)> const& fn)
 {
-    weakReferenceMutex.lock();
-
-    auto& refs = pdWeakReferences[ptr];
-
-    auto it = std::find(refs.begin(), refs.end(), ref);
-
-    if (it != refs.end()) {
-        pdWeakReferences[ptr].erase(it);
-    }
-
-    weakReferenceMutex.unlock();
+    functionQueue.enqueue({ queueSequence.fetch_add(1, std::memory_order_relaxed), fn });
 }
 
-void Instance::clearWeakReferences(void* ptr)
+// Called by pd while holding the pd lock, try_enqueue never allocates
+void Instance::enqueueMidiEvent(MidiEvent::Type type, int channel, int value1, int value2)
 {
-    weakReferenceMutex.lock();
-    for (auto* ref : pdWeakReferences[ptr]) {
-        *ref = false;
-    }
-    pdWeakReferences.erase(ptr);
-    weakReferenceMutex.unlock();
+    if (!midiEventQueue.try_enqueue({ type, channel, value1, value2, queueSequence.fetch_add(1, std::memory_order_relaxed) }))
+        numDroppedMidiEvents.fetch_add(1, std::memory_order_relaxed);
 }
 
-void Instance::enqueueFunctionAsync(std::function<void(void)> const& fn)
+int Instance::getAndResetNumDroppedMidiEvents()
 {
-    functionQueue.enqueue(fn);
+    return numDroppedMidiEvents.exchange(0, std::memory_order_relaxed);
 }
 
 void Instance::enqueueGuiMessage(Message const& message)
@@ -592,6 +571,12 @@ void Instance::sendDirectMessage(void* object, float const msg)
 
 void Instance::handleAsyncUpdate()
 {
+    // Free callbacks that were executed on the audio thread
+    std::function<void(void)> releasedCallback;
+    while (releasedFunctionQueue.try_dequeue(releasedCallback)) {
+        releasedCallback = nullptr;
+    }
+
     Message mess;
     while (guiMessageQueue.try_dequeue(mess)) {
         auto const dest = hash(mess.destination);
@@ -664,14 +649,72 @@ void Instance::handleAsyncUpdate()
 
 void Instance::sendMessagesFromQueue()
 {
+    // Most blocks have nothing queued, so don't take the pd lock unless we need to
+    if (functionQueue.size_approx() == 0 && midiEventQueue.size_approx() == 0)
+        return;
+
     libpd_set_instance(static_cast<t_pdinstance*>(instance));
 
+    // The queues themselves are lock-free, but we still need the pd lock here:
+    // - the queued functions call into pd, which isn't thread-safe
+    // - this is also called from the message thread, and the MIDI queue only supports one consumer at a time
+    // On the audio thread this is the same recursive lock that performDSP takes every block, so it's only contended while the message thread is using pd
     sys_lock();
-    std::function<void(void)> callback;
-    while (functionQueue.try_dequeue(callback)) {
-        callback();
+
+    // Merge the two queues by sequence number, so a message from the GUI that was sent before a MIDI event still reaches pd first
+    bool releasedCallbacks = false;
+    QueuedFunction function;
+    bool hasFunction = functionQueue.try_dequeue(function);
+    auto* midiEvent = midiEventQueue.peek();
+
+    while (hasFunction || midiEvent) {
+        if (hasFunction && (!midiEvent || function.sequence < midiEvent->sequence)) {
+            function.callback();
+
+            // Let the message thread destroy the callback, if the queue is full we have no choice but to do it here
+            if (releasedFunctionQueue.try_enqueue(std::move(function.callback)))
+                releasedCallbacks = true;
+            else
+                function.callback = nullptr;
+
+            // The callback might have made pd send MIDI
+            hasFunction = functionQueue.try_dequeue(function);
+            midiEvent = midiEventQueue.peek();
+            continue;
+        }
+
+        auto const event = *midiEvent;
+        midiEventQueue.pop();
+        midiEvent = midiEventQueue.peek();
+
+        switch (event.type) {
+        case MidiEvent::NoteOn:
+            receiveNoteOn(event.channel + 1, event.value1, event.value2);
+            break;
+        case MidiEvent::ControlChange:
+            receiveControlChange(event.channel + 1, event.value1, event.value2);
+            break;
+        case MidiEvent::ProgramChange:
+            receiveProgramChange(event.channel + 1, event.value1);
+            break;
+        case MidiEvent::PitchBend:
+            receivePitchBend(event.channel + 1, event.value1);
+            break;
+        case MidiEvent::AfterTouch:
+            receiveAftertouch(event.channel + 1, event.value1);
+            break;
+        case MidiEvent::PolyAfterTouch:
+            receivePolyAftertouch(event.channel + 1, event.value1, event.value2);
+            break;
+        case MidiEvent::MidiByte:
+            receiveMidiByte(event.channel + 1, event.value1);
+            break;
+        }
     }
     sys_unlock();
+
+    if (releasedCallbacks)
+        triggerAsyncUpdate();
 }
 
 Patch::Ptr Instance::openPatch(File const& toOpen)
@@ -689,6 +732,19 @@ Patch::Ptr Instance::openPatch(File const& toOpen)
     return new Patch(pd::WeakReference(cnv, this), this, true, toOpen);
 }
 
+// Opens a patch from its content, as if it was opened from the location, without touching the filesystem
+Patch::Ptr Instance::openPatch(String const& content, File const& location)
+{
+    String dirname = location.getParentDirectory().getFullPathName().replace("\\", "/");
+    String filename = location.getFileName();
+
+    setThis();
+
+    auto* cnv = pd::Interface::createCanvasFromText(content.toRawUTF8(), static_cast<int>(content.getNumBytesAsUTF8()), filename.toRawUTF8(), dirname.toRawUTF8());
+
+    return new Patch(pd::WeakReference(cnv, this), this, true, location);
+}
+
 void Instance::setThis() const
 {
     libpd_set_instance(static_cast<t_pdinstance*>(instance));
@@ -839,6 +895,11 @@ void Instance::updateObjectImplementations()
     objectImplementations->updateObjectImplementations();
 }
 
+void Instance::updateObjectImplementations(t_canvas* changedPatch)
+{
+    objectImplementations->updateObjectImplementations(changedPatch);
+}
+
 void Instance::clearObjectImplementationsForPatch(pd::Patch* p)
 {
     if (auto patch = p->getPointer()) {
@@ -15,6 +15,7 @@ extern "C" {
 #include <readerwriterqueue.h>
 #include "Utility/CachedStringWidth.h"
 #include "Patch.h"
+#include "Profiler.h"
 
 class ObjectImplementationManager;
 
@@ -157,6 +158,30 @@ class Instance : public AsyncUpdater {
         std::vector<pd::Atom> list;
     };
 
+    // Typed record for MIDI coming out of Pd, so we don't need to allocate a std::function for every MIDI message
+    struct MidiEvent {
+        enum Type {
+            NoteOn,
+            ControlChange,
+            ProgramChange,
+            PitchBend,
+            AfterTouch,
+            PolyAfterTouch,
+            MidiByte
+        };
+
+        Type type;
+        int channel;
+        int value1;
+        int value2;
+        uint64 sequence; // Position in the combined order of queued functions and MIDI events
+    };
+
+    struct QueuedFunction {
+        uint64 sequence;
+        std::function<void(void)> callback;
+    };
+
 public:
     explicit Instance();
     Instance(Instance const& other) = delete;
@@ -206,9 +231,6 @@ public:
     void registerMessageListener(void* object, MessageListener* messageListener);
     void unregisterMessageListener(void* object, MessageListener* messageListener);
 
-    void registerWeakReference(void* ptr, pd_weak_reference* ref);
-    void unregisterWeakReference(void* ptr, pd_weak_reference const* ref);
-    void clearWeakReferences(void* ptr);
 
     static void registerLuaClass(char const* object);
     bool isLuaClass(hash32 objectNameHash);
@@ -226,7 +248,7 @@ public:
     template<typename T>
     void enqueueFunctionAsync(WeakReference& ref, std::function<void(T*)> const& fn)
     {
-        functionQueue.enqueue([ref, fn]() {
+        enqueueFunctionAsync([ref, fn]() {
             if (auto obj = ref.get<T>()) {
                 fn(obj.get());
             }
@@ -239,6 +261,7 @@ public:
     void sendDirectMessage(void* object, float msg);
 
     void updateObjectImplementations();
+    void updateObjectImplementations(t_canvas* changedPatch);
     void clearObjectImplementationsForPatch(pd::Patch* p);
 
     virtual void performParameterChange(int type, String const& name, float value) = 0;
@@ -260,9 +283,13 @@ public:
     std::deque<std::tuple<void*, String, int, int, int>>& getConsoleHistory();
 
     void sendMessagesFromQueue();
-    void processSend(dmessage mess);
+    void processSend(dmessage const& mess);
+
+    // MIDI events from pd that didn't fit in the queue since the last call
+    int getAndResetNumDroppedMidiEvents();
 
     Patch::Ptr openPatch(File const& toOpen);
+    Patch::Ptr openPatch(String const& content, File const& location);
 
     virtual void reloadAbstractions(File changedPatch, t_glist* except) = 0;
 
@@ -292,18 +319,32 @@ public:
 
     bool isPerformingGlobalSync = false;
     CriticalSection const audioLock;
-    std::recursive_mutex weakReferenceMutex;
+    WeakReferenceTable weakReferences;
     std::unique_ptr<pd::MessageDispatcher> messageDispatcher;
+    std::unique_ptr<DSPProfiler> dspProfiler;
 
     // All opened patches
     Array<pd::Patch::Ptr, CriticalSection> patches;
 
 private:
-    std::unordered_map<void*, std::vector<pd_weak_reference*>> pdWeakReferences;
-
-    moodycamel::ConcurrentQueue<std::function<void(void)>> functionQueue = moodycamel::ConcurrentQueue<std::function<void(void)>>(4096);
+    // Functions and MIDI events are executed in the order they were queued in, which is kept track of with a shared sequence number
+    // Functions queued from the same thread always come out in order, across threads the sequence number decides
+    std::atomic<uint64> queueSequence = 0;
+    moodycamel::ConcurrentQueue<QueuedFunction> functionQueue = moodycamel::ConcurrentQueue<QueuedFunction>(4096);
     moodycamel::ConcurrentQueue<Message> guiMessageQueue = moodycamel::ConcurrentQueue<Message>(64);
 
+    // Only written and read while holding the pd lock, so a preallocated single producer/single consumer queue is enough
+    // We only write to it with try_enqueue, which never allocates. midiout sends sysex one byte at a time, so this has room for a 16kB sysex per block
+    // Events that don't fit are counted, so they can be reported from the message thread
+    moodycamel::ReaderWriterQueue<MidiEvent> midiEventQueue = moodycamel::ReaderWriterQueue<MidiEvent>(16384);
+    std::atomic<int> numDroppedMidiEvents = 0;
+
+    void enqueueMidiEvent(MidiEvent::Type type, int channel, int value1, int value2);
+
+    // Callbacks that were executed on the audio thread are handed to the message thread to be freed, because destroying them might deallocate captured state
+    // Filled while holding the pd lock, emptied on the message thread
+    moodycamel::ReaderWriterQueue<std::function<void(void)>> releasedFunctionQueue = moodycamel::ReaderWriterQueue<std::function<void(void)>>(4096);
+
     std::unique_ptr<FileChooser> openChooser;
     static inline std::set<hash32> luaClasses = std::set<hash32>(); // Keep track of class names that correspond to pdlua objects
 
@@ -19,6 +19,10 @@ extern int glist_getindex(t_glist* cnv, t_gobj* y);
 extern void canvas_savedeclarationsto(t_canvas* x, t_binbuf* b);
 extern void canvas_savetemplatesto(t_canvas* x, t_binbuf* b, int wholething);
 extern void canvas_saveto(t_canvas* x, t_binbuf* b);
+extern void text_save(t_gobj* z, t_binbuf* b);
+extern void glob_setfilename(void* dummy, t_symbol* filesym, t_symbol* dirsym);
+extern void canvas_initbang(t_canvas* x);
+extern void pd_doloadbang(void);
 extern void canvas_doclick(t_canvas *x, int xpos, int ypos, int which, int mod, int doit);
 extern void canvas_doconnect(t_canvas *x, int xpos, int ypos, int mod, int doit);
 extern void set_class_prefix(t_symbol*);
@@ -39,6 +43,62 @@ struct Interface {
         return cnv;
     }
 
+    // Does the same as createCanvas, but evaluates the patch text directly instead of reading it from a file
+    // The name and directory are used as if the patch was opened from that file, so abstractions and resources are found relative to it
+    static t_canvas* createCanvasFromText(char const* text, int size, char const* name, char const* path)
+    {
+        // Same locking as libpd_openfile: evaluating a patch touches globals that are shared between instances, like the class tables
+        sys_lock();
+        pd_globallock();
+
+        t_binbuf* b = binbuf_new();
+        binbuf_text(b, text, size);
+
+        int const dspState = canvas_suspend_dsp();
+
+        // Same as glob_evalfile and binbuf_evalfile: save the bindings of #X, #A and #N, and restore them afterwards
+        auto* boundX = s__X.s_thing;
+        auto* boundA = gensym("#A")->s_thing;
+        auto* boundN = s__N.s_thing;
+        s__X.s_thing = nullptr;
+        gensym("#A")->s_thing = nullptr;
+        s__N.s_thing = &pd_canvasmaker;
+
+        glob_setfilename(nullptr, gensym(name), gensym(path));
+        binbuf_eval(b, nullptr, 0, nullptr);
+        glob_setfilename(nullptr, &s_, &s_);
+
+        t_canvas* cnv = nullptr;
+        if (s__X.s_thing && *s__X.s_thing == canvas_class) {
+            cnv = reinterpret_cast<t_canvas*>(s__X.s_thing);
+            canvas_initbang(cnv);
+        }
+
+        t_pd* x = nullptr;
+        while (x != s__X.s_thing && s__X.s_thing) {
+            x = s__X.s_thing;
+            vmess(x, gensym("pop"), "i", 1);
+        }
+
+        if (!sys_noloadbang)
+            pd_doloadbang();
+
+        gensym("#A")->s_thing = boundA;
+        s__N.s_thing = boundN;
+        s__X.s_thing = boundX;
+
+        canvas_resume_dsp(dspState);
+        binbuf_free(b);
+
+        pd_globalunlock();
+        sys_unlock();
+
+        if (cnv) {
+            canvas_vis(cnv, 1.f);
+        }
+        return cnv;
+    }
+
     static char const* getObjectClassName(t_pd* ptr)
     {
         return class_getname(pd_class(ptr));
@@ -793,6 +853,101 @@ struct Interface {
         binbuf_free(b);
     }
 
+    // Hashes everything that getCanvasContent writes, which is a lot cheaper than building the patch text
+    // Returns false if the canvas contains objects that save their own state (like arrays or iemguis), because we can't tell when that state changes
+    static bool getCanvasFingerprint(t_canvas* cnv, uint64_t& hash)
+    {
+        auto combine = [&hash](uint64_t value) {
+            hash = (hash ^ value) * 0x100000001b3ull;
+        };
+
+        auto combineFloat = [&combine](t_float value) {
+            uint64_t bits = 0;
+            std::memcpy(&bits, &value, sizeof(t_float));
+            combine(bits);
+        };
+
+        auto combineText = [&combine, &combineFloat](t_text* text) {
+            combine(text->te_type);
+            combine(static_cast<uint64_t>(text->te_xpix));
+            combine(static_cast<uint64_t>(text->te_ypix));
+            combine(static_cast<uint64_t>(text->te_width));
+
+            auto const numAtoms = binbuf_getnatom(text->te_binbuf);
+            auto const* atoms = binbuf_getvec(text->te_binbuf);
+            combine(numAtoms);
+            for (int i = 0; i < numAtoms; i++) {
+                combine(atoms[i].a_type);
+                switch (atoms[i].a_type) {
+                case A_FLOAT:
+                    combineFloat(atoms[i].a_w.w_float);
+                    break;
+                case A_DOLLAR:
+                    combine(atoms[i].a_w.w_index);
+                    break;
+                case A_SYMBOL:
+                case A_DOLLSYM:
+                    combine(reinterpret_cast<uintptr_t>(atoms[i].a_w.w_symbol)); // Symbols are unique, so the pointer identifies the string
+                    break;
+                default:
+                    break;
+                }
+            }
+        };
+
+        combine(static_cast<uint64_t>(cnv->gl_screenx1));
+        combine(static_cast<uint64_t>(cnv->gl_screeny1));
+        combine(static_cast<uint64_t>(cnv->gl_screenx2));
+        combine(static_cast<uint64_t>(cnv->gl_screeny2));
+        combine(cnv->gl_font);
+        combine(cnv->gl_mapped);
+        combine(cnv->gl_isgraph);
+        combine(cnv->gl_goprect);
+        combine(cnv->gl_hidetext);
+        combine(static_cast<uint64_t>(cnv->gl_pixwidth));
+        combine(static_cast<uint64_t>(cnv->gl_pixheight));
+        combine(static_cast<uint64_t>(cnv->gl_xmargin));
+        combine(static_cast<uint64_t>(cnv->gl_ymargin));
+        combineFloat(cnv->gl_x1);
+        combineFloat(cnv->gl_y1);
+        combineFloat(cnv->gl_x2);
+        combineFloat(cnv->gl_y2);
+
+        for (auto* y = cnv->gl_list; y; y = y->g_next) {
+            auto* objectClass = pd_class(&y->g_pd);
+            combine(reinterpret_cast<uintptr_t>(y));
+            combine(reinterpret_cast<uintptr_t>(objectClass));
+
+            // Abstractions are saved as a regular object box, subpatches also save their content
+            if (objectClass == canvas_class) {
+                auto* subpatch = reinterpret_cast<t_canvas*>(y);
+                combineText(&subpatch->gl_obj);
+                if (!canvas_isabstraction(subpatch) && !getCanvasFingerprint(subpatch, hash))
+                    return false;
+                continue;
+            }
+
+            auto const saveFunction = class_getsavefn(objectClass);
+            if (saveFunction && saveFunction != text_save)
+                return false;
+
+            if (saveFunction)
+                combineText(reinterpret_cast<t_text*>(y));
+        }
+
+        t_linetraverser t;
+        linetraverser_start(&t, cnv);
+        while (linetraverser_next_nosize(&t)) {
+            combine(reinterpret_cast<uintptr_t>(t.tr_ob));
+            combine(static_cast<uint64_t>(t.tr_outno));
+            combine(reinterpret_cast<uintptr_t>(t.tr_ob2));
+            combine(static_cast<uint64_t>(t.tr_inno));
+            combine(reinterpret_cast<uintptr_t>(t.outconnect_path_info));
+        }
+
+        return true;
+    }
+
     static int numOutlets(t_object const* x)
     {
         return obj_noutlets(x);
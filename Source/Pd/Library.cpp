@@ -43,6 +43,11 @@ Library::Library(pd::Instance* instance) : Thread("Library Index Thread"), pd(in
     watcher.addFolder(ProjectInfo::appDataDir);
     watcher.addListener(this);
 
+    directoryIndexWatcher.onChange = [this]() {
+        directoryIndex.clear();
+    };
+    directoryWatcher.addListener(&directoryIndexWatcher);
+
     // Needs to be async, otherwise LV2 validation fails
     MessageManager::callAsync([this, pd = juce::WeakReference(pd)]() {
         if (pd.get()) {
@@ -57,6 +62,8 @@ Library::Library(pd::Instance* instance) : Thread("Library Index Thread"), pd(in
 Library::~Library()
 {
     appDirChanged = nullptr;
+    signalThreadShouldExit();
+    notify();
     waitForThreadToExit(-1);
 }
 
@@ -65,6 +72,9 @@ void Library::updateLibrary()
     auto settingsTree = ValueTree::fromXml(ProjectInfo::appDataDir.getChildFile(".settings").loadFileAsString());
     auto pathTree = settingsTree.getChildWithName("Paths");
 
+    StringArray pdObjects;
+
+    // Only reading the method table needs the pd lock, the rest of the indexing happens on the library thread
     sys_lock();
 
     // Get available objects directly from pd
@@ -73,8 +83,6 @@ void Library::updateLibrary()
     auto* mlist = static_cast<t_methodentry*>(libpd_get_class_methods(o));
     t_methodentry* m;
 
-    allObjects.clear();
-
     int i;
     for (i = o->c_nmethod, m = mlist; i--; m++) {
         if (!m || !m->me_name)
@@ -82,15 +90,45 @@ void Library::updateLibrary()
 
         auto newName = String::fromUTF8(m->me_name->s_name);
         if (!(newName.startsWith("else/") || newName.startsWith("cyclone/") || newName.endsWith("_aliased"))) {
-            allObjects.add(newName);
+            pdObjects.add(newName);
         }
     }
 
-    // Find patches in our search tree
+    sys_unlock();
+
+    Array<File> searchPaths;
     for (auto path : pathTree) {
-        auto filePath = path.getProperty("Path").toString();
+        searchPaths.add(File(path.getProperty("Path").toString()));
+    }
+
+    // Make the objects from pd available right away, together with the abstractions we found last time
+    // The library thread might still be busy indexing the documentation, so it could take a while before the search paths are crawled
+    publishObjectIndex(pdObjects, getObjectIndex()->abstractions);
+
+    {
+        std::lock_guard<std::recursive_mutex> lock(libraryLock);
+        pendingIndexRequest = { pdObjects, searchPaths };
+        hasPendingIndexRequest = true;
+    }
+
+    notify();
+}
+
+std::shared_ptr<Library::ObjectIndex const> Library::getObjectIndex() const
+{
+    std::lock_guard<std::recursive_mutex> lock(libraryLock);
+    return objectIndex;
+}
+
+void Library::updateObjectIndex(StringArray const& pdObjects, Array<File> const& searchPaths)
+{
+    StringArray abstractions;
+
+    // Find patches in our search tree
+    for (auto const& file : searchPaths) {
+        if (threadShouldExit())
+            return;
 
-        auto file = File(filePath);
         if (!file.exists() || !file.isDirectory())
             continue;
 
@@ -98,12 +136,24 @@ void Library::updateLibrary()
             if (file.hasFileExtension("pd")) {
                 auto filename = file.getFileNameWithoutExtension();
                 if (!filename.startsWith("help-") && !filename.endsWith("-help")) {
-                    allObjects.add(filename);
+                    abstractions.add(filename);
                 }
             }
         }
     }
 
+    publishObjectIndex(pdObjects, abstractions);
+}
+
+void Library::publishObjectIndex(StringArray const& pdObjects, StringArray const& abstractions)
+{
+    auto newIndex = std::make_shared<ObjectIndex>();
+    newIndex->abstractions = abstractions;
+
+    auto& allObjects = newIndex->allObjects;
+    allObjects = pdObjects;
+    allObjects.addArray(abstractions);
+
     // These can't be created by name in Pd, but plugdata allows it
     allObjects.add("graph");
     allObjects.add("garray");
@@ -113,11 +163,42 @@ void Library::updateLibrary()
     allObjects.add("symbol");
     allObjects.add("list");
 
-    sys_unlock();
-}
+    auto& sortedObjects = newIndex->sortedObjects;
+    sortedObjects.reserve(allObjects.size());
+    for (auto const& name : allObjects) {
+        sortedObjects.push_back(name);
+    }
+    std::sort(sortedObjects.begin(), sortedObjects.end());
+    sortedObjects.erase(std::unique(sortedObjects.begin(), sortedObjects.end()), sortedObjects.end());
 
+    // Readers hold on to the old index for as long as they need it, so we can just swap it out
+    std::lock_guard<std::recursive_mutex> lock(libraryLock);
+    objectIndex = std::move(newIndex);
+}
 
 void Library::run()
+{
+    indexDocumentation();
+
+    while (!threadShouldExit()) {
+        wait(-1);
+
+        StringArray pdObjects;
+        Array<File> searchPaths;
+        {
+            std::lock_guard<std::recursive_mutex> lock(libraryLock);
+            if (!hasPendingIndexRequest)
+                continue;
+
+            std::tie(pdObjects, searchPaths) = pendingIndexRequest;
+            hasPendingIndexRequest = false;
+        }
+
+        updateObjectIndex(pdObjects, searchPaths);
+    }
+}
+
+void Library::indexDocumentation()
 {
     MemoryInputStream instream(BinaryData::Documentation_bin, BinaryData::Documentation_binSize, false);
     ValueTree documentationTree = ValueTree::readFromStream(instream);
@@ -200,33 +281,60 @@ bool Library::isGemObject(String const& query) const
     return gemObjects.contains(query);
 }
 
+std::vector<String> const& Library::getAbstractionsInDirectory(File const& directory) const
+{
+    auto const path = directory.getFullPathName();
+    if (auto it = directoryIndex.find(path); it != directoryIndex.end()) {
+        return it->second;
+    }
+
+    // Don't keep watching every directory we ever opened a patch in
+    if (directoryIndex.size() >= 16) {
+        directoryIndex.clear();
+        directoryWatcher.removeAllFolders();
+    }
+
+    std::vector<String> abstractions;
+    for (auto const& file : OSUtils::iterateDirectory(directory, false, true, 1000)) {
+        auto filename = file.getFileNameWithoutExtension();
+        if (file.hasFileExtension("pd") && !filename.startsWith("help-") && !filename.endsWith("-help")) {
+            abstractions.push_back(filename);
+        }
+    }
+    std::sort(abstractions.begin(), abstractions.end());
+
+    directoryWatcher.addFolder(directory);
+    return directoryIndex[path] = std::move(abstractions);
+}
+
 StringArray Library::autocomplete(String const& query, File const& patchDirectory) const
 {
     StringArray result;
     result.ensureStorageAllocated(20);
 
+    // Finds all names that start with the query in a sorted list
+    auto addPrefixMatches = [&query, &result](std::vector<String> const& names) {
+        for (auto it = std::lower_bound(names.begin(), names.end(), query); it != names.end() && it->startsWith(query); ++it) {
+            if (result.size() >= 20)
+                break;
+
+            result.addIfNotAlreadyThere(*it);
+        }
+    };
+
     // First, look for non-help patches in the current patch directory
     if (patchDirectory.isDirectory()) {
-        for (auto const& file : OSUtils::iterateDirectory(patchDirectory, false, true, 20)) {
-            auto filename = file.getFileNameWithoutExtension();
-            if (file.hasFileExtension("pd") && filename.startsWith(query) && !filename.startsWith("help-") && !filename.endsWith("-help")) {
-                result.add(filename);
-            }
-        }
+        addPrefixMatches(getAbstractionsInDirectory(patchDirectory));
     }
 
     // Then, go over all regular objects for direct autocompletion
-    for (auto const& str : allObjects) {
-        if (result.size() >= 20)
-            break;
+    addPrefixMatches(getObjectIndex()->sortedObjects);
 
-        if (str.startsWith(query)) {
-            result.addIfNotAlreadyThere(str);
-        }
-    }
-    
     result.sort(true);
-    
+
+    if (result.size() >= 20)
+        return result;
+
     // Finally, do a fuzzy search of all object documentation
     auto fuzzyResults = searchDatabase.search(query.toStdString());
     for(auto& fuzzyMatch : fuzzyResults)
@@ -247,7 +355,9 @@ StringArray Library::searchObjectDocumentation(String const& query)
     StringArray result;
     result.ensureStorageAllocated(20);
     
-    for (auto const& str : allObjects) {
+    // Keep the index alive while we iterate over it, the library thread could swap it out in the meantime
+    auto const index = getObjectIndex();
+    for (auto const& str : index->allObjects) {
         if (str.startsWith(query)) {
             result.addIfNotAlreadyThere(str);
         }
@@ -327,7 +437,7 @@ std::array<StringArray, 2> Library::parseIoletTooltips(ValueTree const& iolets,
 
 StringArray Library::getAllObjects()
 {
-    return allObjects;
+    return getObjectIndex()->allObjects;
 }
 
 void Library::filesystemChanged()
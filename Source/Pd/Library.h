@@ -78,10 +78,46 @@ public:
     static inline StringArray objectOrigins = { "vanilla", "ELSE", "cyclone", "Gem", "heavylib", "pdlua" };
 
 private:
-    StringArray allObjects;
+    // Invalidates the cached abstraction index of a patch directory when its contents change
+    struct DirectoryIndexWatcher : public FileSystemWatcher::Listener {
+        std::function<void()> onChange;
+
+        void filesystemChanged() override
+        {
+            onChange();
+        }
+    };
+
+    // Immutable list of all objects, rebuilt on the library thread and swapped in when ready
+    struct ObjectIndex {
+        StringArray allObjects;
+
+        // Abstractions found in the search paths, kept so we can republish the index without crawling again
+        StringArray abstractions;
+
+        // All object names in sorted order, so we can find all names with a given prefix using binary search
+        std::vector<String> sortedObjects;
+    };
+
+    std::shared_ptr<ObjectIndex const> getObjectIndex() const;
+    void publishObjectIndex(StringArray const& pdObjects, StringArray const& abstractions);
+    void updateObjectIndex(StringArray const& pdObjects, Array<File> const& searchPaths);
+    void indexDocumentation();
+
+    std::vector<String> const& getAbstractionsInDirectory(File const& directory) const;
+
     StringArray gemObjects;
+
+    std::shared_ptr<ObjectIndex const> objectIndex = std::make_shared<ObjectIndex>();
+    std::pair<StringArray, Array<File>> pendingIndexRequest;
+    bool hasPendingIndexRequest = false;
+
+    // Only accessed from the message thread
+    mutable std::unordered_map<String, std::vector<String>> directoryIndex;
+    DirectoryIndexWatcher directoryIndexWatcher;
+    mutable FileSystemWatcher directoryWatcher;
     
-    std::recursive_mutex libraryLock;
+    mutable std::recursive_mutex libraryLock;
     
     fuzzysearch::Database<ValueTree> searchDatabase;
 
@@ -6,8 +6,7 @@
 #pragma once
 
 #include "Instance.h"
-#include "Utility/ThreadSafeStack.h"
-#include <readerwriterqueue.h>
+#include <thread>
 
 namespace pd {
 
@@ -64,112 +63,218 @@ class MessageDispatcher {
         }
     };
 
-public:
-    MessageDispatcher()
-    {
-        usedHashes.reserve(stackSize);
-        nullListeners.reserve(stackSize);
-    }
+    // Holds the latest message for every target and selector that was sent since the last time we dispatched
+    // Messages that arrive faster than we can display them overwrite each other instead of piling up
+    // Uses open addressing on fixed size storage, so inserting never allocates
+    class MessageTable {
+    public:
+        MessageTable()
+            : slots(numSlots)
+            , messages(maxMessages)
+            , usedSlots(maxMessages)
+        {
+        }
+
+        // Returns false if there is no more room in the table
+        bool insert(void* target, t_symbol* symbol, int argc, t_atom* argv)
+        {
+            auto index = getHash(target, symbol) & (numSlots - 1);
+            while (true) {
+                auto& slot = slots[index];
+                if (slot.message < 0) {
+                    if (numMessages == maxMessages)
+                        return false;
+
+                    slot = { target, symbol, numMessages };
+                    usedSlots[numMessages] = index;
+                    messages[numMessages++] = Message(target, symbol, argc, argv);
+                    return true;
+                }
+                if (slot.target == target && slot.symbol == symbol) {
+                    messages[slot.message] = Message(target, symbol, argc, argv);
+                    return true;
+                }
+
+                index = (index + 1) & (numSlots - 1);
+            }
+        }
+
+        // Iterates over messages in the order that their target and selector first appeared in
+        Message const* begin() const { return messages.data(); }
+        Message const* end() const { return messages.data() + numMessages; }
 
+        void clear()
+        {
+            for (int i = 0; i < numMessages; i++) {
+                slots[usedSlots[i]].message = -1;
+            }
+            numMessages = 0;
+        }
+
+    private:
+        static constexpr int maxMessages = 1 << 14;
+        static constexpr int numSlots = maxMessages * 2; // Keep the load factor below 0.5, so probe sequences stay short
+
+        struct Slot {
+            void* target = nullptr;
+            t_symbol* symbol = nullptr;
+            int message = -1;
+        };
+
+        static int getHash(void* target, t_symbol* symbol)
+        {
+            auto hash = reinterpret_cast<uint64>(target) * 0x9E3779B97F4A7C15ull ^ reinterpret_cast<uint64>(symbol) * 0xC2B2AE3D27D4EB4Full;
+            return static_cast<int>(hash >> 32);
+        }
+
+        std::vector<Slot> slots;
+        std::vector<Message> messages;
+        std::vector<int> usedSlots;
+        int numMessages = 0;
+    };
+
+public:
+    // Called while holding the pd lock, which can be on the audio thread or on the message thread
+    // Never blocks and never allocates
     void enqueueMessage(void* target, t_symbol* symbol, int argc, t_atom* argv)
     {
-        if(block) return;
-        
-        messageStack.push({ target, symbol, argc, argv });
+        if (block)
+            return;
+
+        // Tell the message thread which table we're writing to, and check that it didn't swap the tables in the meantime
+        auto tableIndex = writeTable.load();
+        while (true) {
+            busyTable.store(tableIndex);
+            auto const currentTable = writeTable.load();
+            if (currentTable == tableIndex)
+                break;
+
+            tableIndex = currentTable;
+        }
+
+        // If the table is full, there are way more messages than we can ever display, so we drop them
+        tables[tableIndex].insert(target, symbol, argc, argv);
+
+        busyTable.store(-1, std::memory_order_release);
     }
-    
+
     // used when no plugineditor is active, so we can just ignore messages
     void setBlockMessages(bool blockMessages)
     {
         block = blockMessages;
-        
+
         // If we're blocking messages from now on, also clear out the queue
-        if(blockMessages)
-        {
-            Message message;
-            while (messageStack.pop(message)) {}
-            messageStack.swapBuffers();
-            while (messageStack.pop(message)) {}
+        if (blockMessages) {
+            swapTables().clear();
+            swapTables().clear();
         }
     }
 
     void addMessageListener(void* object, pd::MessageListener* messageListener)
     {
         ScopedLock lock(messageListenerLock);
-        messageListeners[object].insert(juce::WeakReference(messageListener));
+        auto& listeners = messageListeners[object];
+        if (std::find(listeners.begin(), listeners.end(), messageListener) == listeners.end()) {
+            listeners.push_back(juce::WeakReference(messageListener));
+        }
     }
 
     void removeMessageListener(void* object, MessageListener* messageListener)
     {
         ScopedLock lock(messageListenerLock);
 
-        if (!messageListeners.count(object))
+        auto it = messageListeners.find(object);
+        if (it == messageListeners.end())
             return;
 
-        auto& listeners = messageListeners[object];
-        auto it = std::find(listeners.begin(), listeners.end(), messageListener);
-
-        if (it != listeners.end())
-            listeners.erase(it);
+        // Listeners can be removed from inside a callback, so we can't modify the list while dispatching
+        for (auto& listener : it->second) {
+            if (listener == messageListener) {
+                listener = nullptr;
+            }
+        }
 
-        if (listeners.empty())
-            messageListeners.erase(object);
+        if (isDispatching) {
+            targetsToClean.push_back(object);
+        } else {
+            removeNullListeners(object);
+        }
     }
 
     void dequeueMessages() // Note: make sure correct pd instance is active when calling this
     {
-        usedHashes.clear();
-        nullListeners.clear();
-
-        messageStack.swapBuffers();
-        Message message;
-        while (messageStack.pop(message)) {
-            auto hash = reinterpret_cast<intptr_t>(message.target) ^ reinterpret_cast<intptr_t>(message.symbol);
-            if (usedHashes.find(hash) != usedHashes.end()) {
-                continue;
-            }
-            usedHashes.insert(hash);
+        auto& table = swapTables();
+        auto* emptySymbol = gensym("");
 
-            if (messageListeners.find(message.target) == messageListeners.end())
+        isDispatching = true;
+        for (auto const& message : table) {
+            auto it = messageListeners.find(message.target);
+            if (it == messageListeners.end())
                 continue;
 
-            for (auto it = messageListeners.at(message.target).begin(); it != messageListeners.at(message.target).end(); ++it) {
-                if (it->wasObjectDeleted())
-                    continue;
-
-                auto listener = it->get();
-
-                pd::Atom atoms[8];
-                for (int at = 0; at < message.size; at++) {
-                    atoms[at] = pd::Atom(message.data + at);
-                }
-                auto symbol = message.symbol ? message.symbol : gensym("");
+            pd::Atom atoms[8];
+            for (int at = 0; at < message.size; at++) {
+                atoms[at] = pd::Atom(message.data + at);
+            }
+            auto* symbol = message.symbol ? message.symbol : emptySymbol;
 
-                if (listener)
+            // Index based, since listeners might be added while we're iterating
+            auto& listeners = it->second;
+            for (size_t i = 0; i < listeners.size(); i++) {
+                if (auto* listener = listeners[i].get()) {
                     listener->receiveMessage(symbol, atoms, message.size);
-                else
-                    nullListeners.push_back({ message.target, it });
+                } else {
+                    targetsToClean.push_back(message.target);
+                }
             }
         }
+        isDispatching = false;
+
+        table.clear();
 
-        for (int i = nullListeners.size() - 1; i >= 0; i--) {
-            auto& [target, iterator] = nullListeners[i];
-            messageListeners[target].erase(iterator);
+        for (auto* target : targetsToClean) {
+            removeNullListeners(target);
         }
+        targetsToClean.clear();
     }
 
 private:
-    static constexpr int stackSize = 65536;
-    using MessageStack = ThreadSafeStack<Message, stackSize>;
+    // Hands the table that the producer was writing to over to the message thread, and makes the producer write into the other one
+    MessageTable& swapTables()
+    {
+        auto const tableToRead = writeTable.load();
+        writeTable.store(1 - tableToRead);
+
+        // The producer might still be writing a message into the table we just took, but that should only take a moment
+        while (busyTable.load() == tableToRead) {
+            std::this_thread::yield();
+        }
 
-    std::vector<std::pair<void*, std::set<juce::WeakReference<pd::MessageListener>>::iterator>> nullListeners;
-    std::unordered_set<intptr_t> usedHashes;
-    MessageStack messageStack;
+        return tables[tableToRead];
+    }
+
+    void removeNullListeners(void* target)
+    {
+        auto it = messageListeners.find(target);
+        if (it == messageListeners.end())
+            return;
+
+        auto& listeners = it->second;
+        listeners.erase(std::remove_if(listeners.begin(), listeners.end(), [](auto const& listener) { return listener.get() == nullptr; }), listeners.end());
+
+        if (listeners.empty())
+            messageListeners.erase(it);
+    }
 
-    // Queue to use in case our fast stack queue is full
-    moodycamel::ConcurrentQueue<Message> backupQueue;
+    // Double buffered, the producer writes into one table while the message thread dispatches the other
+    MessageTable tables[2];
+    std::atomic<int> writeTable = 0;
+    std::atomic<int> busyTable = -1;
 
-    std::unordered_map<void*, std::set<juce::WeakReference<MessageListener>>> messageListeners;
+    // Only accessed from the message thread
+    std::unordered_map<void*, std::vector<juce::WeakReference<MessageListener>>> messageListeners;
+    std::vector<void*> targetsToClean;
+    bool isDispatching = false;
     CriticalSection messageListenerLock;
 
     // Block messages unless an editor has been constructed
@@ -752,6 +752,45 @@ String Patch::getCanvasContent()
     return content;
 }
 
+String Patch::getContentSnapshot()
+{
+    ScopedLock lock(contentSnapshotLock);
+
+    char* buf = nullptr;
+    int bufsize = 0;
+    uint64_t fingerprint = 0xcbf29ce484222325ull;
+    bool isValid = false;
+    bool hasFingerprint = false;
+    bool needsUpdate = true;
+
+    instance->lockAudioThread();
+    if (auto patch = ptr.get<t_canvas>()) {
+        isValid = true;
+        hasFingerprint = pd::Interface::getCanvasFingerprint(patch.get(), fingerprint);
+        needsUpdate = !hasFingerprint || !hasContentSnapshot || fingerprint != contentSnapshotFingerprint;
+        if (needsUpdate) {
+            pd::Interface::getCanvasContent(patch.get(), &buf, &bufsize);
+        }
+    }
+    instance->unlockAudioThread();
+
+    if (!isValid) {
+        hasContentSnapshot = false;
+        contentSnapshot.clear();
+        return {};
+    }
+
+    // Converting the text doesn't need the audio lock
+    if (needsUpdate) {
+        contentSnapshot = String::fromUTF8(buf, static_cast<size_t>(bufsize));
+        contentSnapshotFingerprint = fingerprint;
+        hasContentSnapshot = hasFingerprint;
+        freebytes(static_cast<void*>(buf), static_cast<size_t>(bufsize) * sizeof(char));
+    }
+
+    return contentSnapshot;
+}
+
 void Patch::reloadPatch(File const& changedPatch, t_glist* except)
 {
     auto* dir = gensym(changedPatch.getParentDirectory().getFullPathName().replace("\\", "/").toRawUTF8());
@@ -115,6 +115,10 @@ public:
 
     String getCanvasContent();
 
+    // Like getCanvasContent, but only reads the content from pd again if the patch changed since the last snapshot
+    // Locks the audio thread by itself, only while checking for changes and reading the new content
+    String getContentSnapshot();
+
     static void reloadPatch(File const& changedPatch, t_glist* except);
 
     String getTitle() const;
@@ -153,6 +157,11 @@ private:
 
     int undoQueueSize = 0;
 
+    CriticalSection contentSnapshotLock;
+    String contentSnapshot;
+    uint64_t contentSnapshotFingerprint = 0;
+    bool hasContentSnapshot = false;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Patch)
 };
 } // namespace pd
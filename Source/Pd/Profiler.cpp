@@ -0,0 +1,578 @@
+/*
+ // Copyright (c) 2021-2022 Timothy Schoen.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "Utility/Config.h"
+
+#include <bit>
+
+#include "Instance.h"
+#include "Profiler.h"
+#include "Pd/Interface.h"
+
+extern "C" {
+t_glist* clone_get_instance(t_gobj*, int);
+int clone_get_n(t_gobj*);
+}
+
+namespace pd {
+
+DSPProfiler::DSPProfiler(Instance* instance)
+    : pd(instance)
+    , nanosPerTick(1e9 / static_cast<double>(Time::getHighResolutionTicksPerSecond()))
+{
+}
+
+DSPProfiler::~DSPProfiler()
+{
+    if (numUsers > 0) {
+        pd->lockAudioThread();
+        pd->setThis();
+        restoreChain();
+        pd->unlockAudioThread();
+    }
+}
+
+void DSPProfiler::addUser(Mode mode)
+{
+    if (mode == Mode::Objects)
+        numObjectUsers++;
+
+    if (numUsers++ == 0) {
+        startTimer(250);
+    }
+}
+
+void DSPProfiler::removeUser(Mode mode)
+{
+    jassert(numUsers > 0);
+    if (mode == Mode::Objects) {
+        jassert(numObjectUsers > 0);
+        numObjectUsers--;
+    }
+
+    if (--numUsers == 0) {
+        stopTimer();
+
+        pd->lockAudioThread();
+        pd->setThis();
+        restoreChain();
+        pd->unlockAudioThread();
+
+        statistics.clear();
+        patchStatistics.clear();
+        loadPerObject.clear();
+        sendChangeMessage();
+    }
+}
+
+bool DSPProfiler::isEnabled() const
+{
+    return numUsers > 0;
+}
+
+bool DSPProfiler::isMeasuringObjects() const
+{
+    return numObjectUsers > 0;
+}
+
+void DSPProfiler::reset()
+{
+    pd->lockAudioThread();
+    for (int i = 0; i < chainSize; i++) {
+        entries[i].clearMeasurements();
+    }
+    pd->unlockAudioThread();
+}
+
+std::vector<DSPProfiler::ObjectStatistics> const& DSPProfiler::getStatistics() const
+{
+    return statistics;
+}
+
+std::vector<DSPProfiler::PatchStatistics> const& DSPProfiler::getPatchStatistics() const
+{
+    return patchStatistics;
+}
+
+float DSPProfiler::getLoad(void* object) const
+{
+    auto it = loadPerObject.find(object);
+    return it != loadPerObject.end() ? it->second : 0.0f;
+}
+
+// Only called from the audio thread, so we don't need read-modify-write operations
+void DSPProfiler::ChainEntry::addMeasurement(uint64 nanos)
+{
+    numBlocks.store(numBlocks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    totalNanos.store(totalNanos.load(std::memory_order_relaxed) + nanos, std::memory_order_relaxed);
+
+    if (nanos < minNanos.load(std::memory_order_relaxed))
+        minNanos.store(nanos, std::memory_order_relaxed);
+    if (nanos > maxNanos.load(std::memory_order_relaxed))
+        maxNanos.store(nanos, std::memory_order_relaxed);
+
+    auto& bucket = histogram[jmin<int>(numHistogramBuckets - 1, std::bit_width(nanos))];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void DSPProfiler::ChainEntry::clearMeasurements()
+{
+    numBlocks.store(0, std::memory_order_relaxed);
+    totalNanos.store(0, std::memory_order_relaxed);
+    minNanos.store(std::numeric_limits<uint64>::max(), std::memory_order_relaxed);
+    maxNanos.store(0, std::memory_order_relaxed);
+    for (auto& bucket : histogram) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool DSPProfiler::ownsEntry(t_int* w) const
+{
+    return chain && isPositiveAndBelow(w - chain, chainSize);
+}
+
+DSPProfiler* DSPProfiler::findProfilerForEntry(t_int* w)
+{
+    for (auto& slot : instrumentedProfilers) {
+        auto* profiler = slot.load(std::memory_order_acquire);
+        if (profiler && profiler->ownsEntry(w))
+            return profiler;
+    }
+
+    return nullptr;
+}
+
+bool DSPProfiler::registerInstrumentedChain()
+{
+    for (auto& slot : instrumentedProfilers) {
+        DSPProfiler* expected = nullptr;
+        if (slot.load(std::memory_order_relaxed) == this || slot.compare_exchange_strong(expected, this, std::memory_order_acq_rel))
+            return true;
+    }
+
+    return false;
+}
+
+void DSPProfiler::unregisterInstrumentedChain()
+{
+    for (auto& slot : instrumentedProfilers) {
+        DSPProfiler* expected = this;
+        slot.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel);
+    }
+}
+
+DSPProfiler* DSPProfiler::findProfilerForTrampoline(t_int* w)
+{
+    // The chain normally runs from Instance::performDSP, which sets the profiler for this thread
+    // If it runs from somewhere else, we still need to find the original perform routine, otherwise the rest of the DSP tick would be skipped
+    auto* profiler = currentProfiler;
+    if (!profiler || !profiler->ownsEntry(w))
+        profiler = findProfilerForEntry(w);
+
+    // Trampolines only exist in registered chains, they are removed before the profiler unregisters itself
+    jassert(profiler);
+    return profiler;
+}
+
+t_int* DSPProfiler::profiledPerform(t_int* w)
+{
+    auto* profiler = findProfilerForTrampoline(w);
+    if (!profiler)
+        return nullptr;
+
+    auto& entry = profiler->entries[w - profiler->chain];
+    auto* perform = entry.perform.load(std::memory_order_relaxed);
+
+    auto const start = Time::getHighResolutionTicks();
+    auto* next = perform(w);
+    auto const elapsed = Time::getHighResolutionTicks() - start;
+
+    entry.addMeasurement(static_cast<uint64>(static_cast<double>(elapsed) * profiler->nanosPerTick));
+
+    // This tells us where the arguments of this entry end
+    auto const nextOffset = static_cast<int>((next && profiler->ownsEntry(next) ? next : profiler->chain + profiler->chainSize) - w);
+    auto const previousOffset = entry.nextOffset.load(std::memory_order_relaxed);
+    if (!previousOffset || nextOffset < previousOffset)
+        entry.nextOffset.store(nextOffset, std::memory_order_relaxed);
+
+    // Instrument the next entry, we only know where it starts once the current perform routine has returned
+    if (next && profiler->ownsEntry(next)) {
+        auto& nextEntry = profiler->entries[next - profiler->chain];
+        if (!nextEntry.perform.load(std::memory_order_relaxed)) {
+            nextEntry.perform.store(reinterpret_cast<t_perfroutine>(*next), std::memory_order_relaxed);
+            *next = reinterpret_cast<t_int>(&profiledPerform);
+        }
+    }
+
+    return next;
+}
+
+// Only sits at the start of every root patch, so measuring patches costs two timestamps per patch per block
+t_int* DSPProfiler::patchBoundaryPerform(t_int* w)
+{
+    auto* profiler = findProfilerForTrampoline(w);
+    if (!profiler)
+        return nullptr;
+
+    auto const now = Time::getHighResolutionTicks();
+    auto const index = static_cast<int>(w - profiler->chain);
+
+    // Everything since the previous boundary belongs to the patch that started there
+    // The last boundary is the end of the chain, so it never gets measured, and the next block starts over at the first entry
+    if (profiler->currentSegment >= 0 && profiler->currentSegment < index) {
+        auto const elapsed = now - profiler->currentSegmentStart;
+        profiler->entries[profiler->currentSegment].addMeasurement(static_cast<uint64>(static_cast<double>(elapsed) * profiler->nanosPerTick));
+    }
+
+    profiler->currentSegment = index;
+    profiler->currentSegmentStart = now;
+
+    return profiler->entries[index].perform.load(std::memory_order_relaxed)(w);
+}
+
+void DSPProfiler::timerCallback()
+{
+    pd->lockAudioThread();
+    pd->setThis();
+
+    // Switching between measuring objects and patches starts over with a freshly instrumented chain
+    if (measuringObjects != isMeasuringObjects()) {
+        restoreChain();
+        measuringObjects = isMeasuringObjects();
+    }
+
+    instrumentChain();
+    resolveEntries();
+
+    // We need every entry resolved once to know where the root patches start, after that the per-object trampolines can go
+    if (!measuringObjects && !patchBoundariesInstalled && chainSize > 0 && entries[chainSize - 1].numBlocks.load(std::memory_order_relaxed) > 0) {
+        installPatchBoundaries();
+    }
+
+    pd->unlockAudioThread();
+
+    updateStatistics();
+}
+
+// Must be called while holding the audio lock
+void DSPProfiler::instrumentChain()
+{
+    auto* currentChain = STUFF->st_dspchain;
+    auto const currentChainSize = STUFF->st_dspchainsize;
+
+    // If Pd rebuilt the DSP chain, the old chain (and our trampolines in it) is gone, so start over
+    auto const isTrampoline = [](t_perfroutine perform) { return perform == &profiledPerform || perform == &patchBoundaryPerform; };
+    bool const chainChanged = currentChain != chain || currentChainSize != chainSize || (chain && !isTrampoline(reinterpret_cast<t_perfroutine>(chain[0])));
+    if (!chainChanged)
+        return;
+
+    unregisterInstrumentedChain();
+    chain = nullptr;
+    chainSize = 0;
+    entries.reset();
+    objectParents.clear();
+    objectParentsFound = false;
+    objectInfo.clear();
+    rootPatchNames.clear();
+    patchBoundariesInstalled = false;
+    currentSegment = -1;
+
+    // Don't instrument the chain if a trampoline couldn't find us, that only happens if a lot of instances are profiled at once
+    if (!currentChain || currentChainSize <= 0 || !registerInstrumentedChain())
+        return;
+
+    chain = currentChain;
+    chainSize = currentChainSize;
+    entries = std::make_unique<ChainEntry[]>(static_cast<size_t>(chainSize));
+
+    entries[0].perform.store(reinterpret_cast<t_perfroutine>(chain[0]), std::memory_order_relaxed);
+    chain[0] = reinterpret_cast<t_int>(&profiledPerform);
+}
+
+// Must be called while holding the audio lock
+void DSPProfiler::restoreChain()
+{
+    if (chain && chain == STUFF->st_dspchain) {
+        for (int i = 0; i < chainSize; i++) {
+            if (auto* perform = entries[i].perform.load(std::memory_order_relaxed)) {
+                chain[i] = reinterpret_cast<t_int>(perform);
+            }
+        }
+    }
+
+    unregisterInstrumentedChain();
+    chain = nullptr;
+    chainSize = 0;
+    entries.reset();
+    objectParents.clear();
+    objectParentsFound = false;
+    objectInfo.clear();
+    rootPatchNames.clear();
+    patchBoundariesInstalled = false;
+    currentSegment = -1;
+}
+
+// Must be called while holding the audio lock
+// Finds the object that each perform routine belongs to. Perform routines usually get the object passed as one of their arguments
+// Routines that don't, like the ones for signal arithmetic, will be reported as unattributed
+void DSPProfiler::resolveEntries()
+{
+    // Entries that didn't run yet, like the ones inside a switched off subpatch, can't be resolved: we don't know where their arguments end
+    auto needsResolving = [](ChainEntry const& entry) {
+        auto const nextOffset = entry.nextOffset.load(std::memory_order_relaxed);
+        return nextOffset > 0 && (!entry.resolved || nextOffset < entry.resolvedOffset);
+    };
+
+    bool hasUnresolvedEntries = false;
+    for (int i = 0; i < chainSize; i++) {
+        if (needsResolving(entries[i])) {
+            hasUnresolvedEntries = true;
+            break;
+        }
+    }
+
+    if (!hasUnresolvedEntries)
+        return;
+
+    findObjectParents();
+
+    for (int i = 0; i < chainSize; i++) {
+        auto& entry = entries[i];
+        if (!needsResolving(entry))
+            continue;
+
+        // Arguments run until the entry that the perform routine continued with
+        // For a prolog that skipped its sub-chain, that's the skip target. Once it runs without skipping, it gets resolved again with the shorter range
+        auto const nextOffset = entry.nextOffset.load(std::memory_order_relaxed);
+        auto const argumentsEnd = std::min(i + nextOffset, chainSize);
+
+        entry.object = nullptr;
+        for (int arg = i + 1; arg < argumentsEnd && !entries[arg].perform.load(std::memory_order_relaxed); arg++) {
+            auto it = objectParents.find(reinterpret_cast<t_object*>(chain[arg]));
+            if (it == objectParents.end())
+                continue;
+
+            entry.object = it->first;
+            if (!objectInfo.contains(entry.object)) {
+                char* text;
+                int size;
+                pd::Interface::getObjectText(entry.object, &text, &size);
+
+                auto& info = objectInfo[entry.object];
+                info.name = String::fromUTF8(text, size);
+                info.parents = it->second;
+                freebytes(text, static_cast<size_t>(size));
+            }
+            break;
+        }
+
+        entry.resolved = true;
+        entry.resolvedOffset = nextOffset;
+    }
+}
+
+// Must be called while holding the audio lock
+void DSPProfiler::findObjectParents()
+{
+    if (objectParentsFound)
+        return;
+
+    std::function<void(t_glist*, std::vector<t_glist*> const&)> findObjectsRecursively;
+    findObjectsRecursively = [this, &findObjectsRecursively](t_glist* glist, std::vector<t_glist*> const& parents) {
+        auto patchParents = parents;
+        patchParents.push_back(glist);
+
+        for (auto* y = glist->gl_list; y; y = y->g_next) {
+            if (auto* object = pd::Interface::checkObject(y)) {
+                objectParents[object] = patchParents;
+            }
+            if (pd_class(&y->g_pd) == canvas_class) {
+                findObjectsRecursively(reinterpret_cast<t_glist*>(y), patchParents);
+            }
+            // Every instance of a clone has its own objects in the DSP chain
+            else if (pd_class(&y->g_pd) == clone_class) {
+                for (int i = 0; i < clone_get_n(y); i++) {
+                    findObjectsRecursively(clone_get_instance(y, i), patchParents);
+                }
+            }
+        }
+    };
+
+    for (auto* glist = pd_getcanvaslist(); glist; glist = glist->gl_next) {
+        rootPatchNames[glist] = String::fromUTF8(glist->gl_name->s_name);
+        findObjectsRecursively(glist, {});
+    }
+
+    objectParentsFound = true;
+}
+
+// Must be called while holding the audio lock
+// Pd compiles the root patches one after another, so every root patch is one contiguous range of the chain
+// We keep a trampoline at the start of every range and at the end of the chain, and put the original perform routines back everywhere else
+void DSPProfiler::installPatchBoundaries()
+{
+    auto getRootPatch = [this](ChainEntry const& entry) -> t_glist* {
+        if (!entry.object)
+            return nullptr;
+
+        auto it = objectInfo.find(entry.object);
+        return it != objectInfo.end() && !it->second.parents.empty() ? it->second.parents.front() : nullptr;
+    };
+
+    // Entries that we couldn't attribute belong to the patch that was running before them, or the first patch if nothing ran yet
+    t_glist* currentPatch = nullptr;
+    for (int i = 0; i < chainSize && !currentPatch; i++) {
+        currentPatch = getRootPatch(entries[i]);
+    }
+
+    for (int i = 0; i < chainSize; i++) {
+        auto& entry = entries[i];
+        auto* perform = entry.perform.load(std::memory_order_relaxed);
+        if (!perform)
+            continue;
+
+        auto* rootPatch = getRootPatch(entry);
+        auto const isLastEntry = i == chainSize - 1;
+        auto const isBoundary = i == 0 || isLastEntry || (rootPatch && rootPatch != currentPatch);
+        if (rootPatch)
+            currentPatch = rootPatch;
+
+        entry.segmentPatch = isBoundary && !isLastEntry ? currentPatch : nullptr;
+        entry.clearMeasurements();
+        chain[i] = reinterpret_cast<t_int>(isBoundary ? &patchBoundaryPerform : perform);
+    }
+
+    currentSegment = -1;
+    patchBoundariesInstalled = true;
+}
+
+void DSPProfiler::updateStatistics()
+{
+    if (!measuringObjects) {
+        statistics.clear();
+        loadPerObject.clear();
+
+        std::unordered_map<t_glist*, PatchStatistics> statisticsPerPatch;
+        double totalAverage = 0.0;
+        for (int i = 0; i < chainSize; i++) {
+            auto& entry = entries[i];
+            auto const numBlocks = entry.numBlocks.load(std::memory_order_relaxed);
+            if (!entry.segmentPatch || !numBlocks)
+                continue;
+
+            auto const average = static_cast<double>(entry.totalNanos.load(std::memory_order_relaxed)) / static_cast<double>(numBlocks) / 1000.0;
+            auto& patchStats = statisticsPerPatch[entry.segmentPatch];
+            patchStats.patch = entry.segmentPatch;
+            patchStats.average += average;
+            totalAverage += average;
+        }
+
+        patchStatistics.clear();
+        for (auto& [patch, patchStats] : statisticsPerPatch) {
+            auto name = rootPatchNames.find(patch);
+            patchStats.name = name != rootPatchNames.end() ? name->second : String("(unknown)");
+            patchStats.load = totalAverage > 0.0 ? static_cast<float>(patchStats.average / totalAverage) : 0.0f;
+            patchStatistics.push_back(patchStats);
+        }
+
+        std::sort(patchStatistics.begin(), patchStatistics.end(), [](auto const& a, auto const& b) {
+            return a.average > b.average;
+        });
+
+        sendChangeMessage();
+        return;
+    }
+
+    std::unordered_map<t_object*, ObjectStatistics> statisticsPerObject;
+    double totalAverage = 0.0;
+
+    for (int i = 0; i < chainSize; i++) {
+        auto& entry = entries[i];
+        auto const numBlocks = entry.numBlocks.load(std::memory_order_relaxed);
+        if (!entry.resolved || !numBlocks)
+            continue;
+
+        uint32 counts[numHistogramBuckets];
+        uint64 numMeasurements = 0;
+        for (int bucket = 0; bucket < numHistogramBuckets; bucket++) {
+            counts[bucket] = entry.histogram[bucket].load(std::memory_order_relaxed);
+            numMeasurements += counts[bucket];
+        }
+
+        // The histogram has power-of-two buckets, so this is the upper bound of the bucket that contains the 95th percentile
+        double percentile = 0.0;
+        uint64 cumulative = 0;
+        for (int bucket = 0; bucket < numHistogramBuckets; bucket++) {
+            cumulative += counts[bucket];
+            if (cumulative * 100 >= numMeasurements * 95) {
+                percentile = static_cast<double>(uint64(1) << bucket) / 1000.0;
+                break;
+            }
+        }
+
+        auto const average = static_cast<double>(entry.totalNanos.load(std::memory_order_relaxed)) / static_cast<double>(numBlocks) / 1000.0;
+        totalAverage += average;
+
+        // Objects can have more than one perform routine, we add them up to get the cost of the whole object
+        auto& stats = statisticsPerObject[entry.object];
+        stats.object = entry.object;
+        stats.average += average;
+        stats.minimum += static_cast<double>(entry.minNanos.load(std::memory_order_relaxed)) / 1000.0;
+        stats.maximum += static_cast<double>(entry.maxNanos.load(std::memory_order_relaxed)) / 1000.0;
+        stats.percentile += percentile;
+    }
+
+    statistics.clear();
+    loadPerObject.clear();
+
+    std::unordered_map<t_glist*, PatchStatistics> statisticsPerPatch;
+    for (auto& [object, stats] : statisticsPerObject) {
+        stats.load = totalAverage > 0.0 ? static_cast<float>(stats.average / totalAverage) : 0.0f;
+
+        if (auto it = objectInfo.find(object); it != objectInfo.end()) {
+            stats.name = it->second.name;
+            stats.patch = it->second.parents.empty() ? nullptr : it->second.parents.back();
+
+            // Subpatches and abstractions show the load of everything inside them
+            loadPerObject[object] += stats.load;
+            for (auto* parent : it->second.parents) {
+                loadPerObject[parent] += stats.load;
+            }
+
+            if (!it->second.parents.empty()) {
+                auto* rootPatch = it->second.parents.front();
+                auto& patchStats = statisticsPerPatch[rootPatch];
+                patchStats.patch = rootPatch;
+                patchStats.average += stats.average;
+                patchStats.load += stats.load;
+            }
+        } else {
+            stats.name = "(unattributed)";
+        }
+
+        statistics.push_back(stats);
+    }
+
+    std::sort(statistics.begin(), statistics.end(), [](auto const& a, auto const& b) {
+        return a.average > b.average;
+    });
+
+    patchStatistics.clear();
+    for (auto& [patch, patchStats] : statisticsPerPatch) {
+        auto name = rootPatchNames.find(patch);
+        patchStats.name = name != rootPatchNames.end() ? name->second : String("(unknown)");
+        patchStatistics.push_back(patchStats);
+    }
+
+    std::sort(patchStatistics.begin(), patchStatistics.end(), [](auto const& a, auto const& b) {
+        return a.average > b.average;
+    });
+
+    sendChangeMessage();
+}
+
+}
@@ -0,0 +1,165 @@
+/*
+ // Copyright (c) 2021-2022 Timothy Schoen.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <m_pd.h>
+
+namespace pd {
+
+class Instance;
+
+// Measures how long every perform routine in Pd's DSP chain takes
+// While enabled, the perform routines in the DSP chain are replaced with a trampoline that times the original routine
+// The chain is instrumented lazily from the audio thread: every entry instruments the next one, so the whole chain is covered after one block
+// Timings are written by the audio thread into per-entry atomics, so the GUI can read them without locking
+// When only the load per patch is needed, the per-object trampolines are removed again once the chain is resolved,
+// leaving a timestamp at every point where the chain moves on to the next root patch
+class DSPProfiler : public Timer
+    , public ChangeBroadcaster {
+public:
+    struct ObjectStatistics {
+        t_object* object = nullptr;
+        t_glist* patch = nullptr;
+        String name;
+
+        // In microseconds per block
+        double average = 0.0;
+        double minimum = 0.0;
+        double maximum = 0.0;
+        double percentile = 0.0; // 95th percentile
+
+        // Fraction of the total measured DSP time
+        float load = 0.0f;
+    };
+
+    // Everything inside a root patch added up
+    struct PatchStatistics {
+        t_glist* patch = nullptr;
+        String name;
+
+        double average = 0.0; // In microseconds per block
+        float load = 0.0f;    // Fraction of the total measured DSP time
+    };
+
+    enum class Mode {
+        Objects, // Times every perform routine, this adds overhead to every object in the chain
+        Patches  // Only times every root patch as a whole, cheap enough to leave running
+    };
+
+    explicit DSPProfiler(Instance* instance);
+    ~DSPProfiler() override;
+
+    // The profiler is active while anything is displaying its results
+    // Objects are measured while there is at least one user that needs them
+    void addUser(Mode mode = Mode::Objects);
+    void removeUser(Mode mode = Mode::Objects);
+    bool isEnabled() const;
+    bool isMeasuringObjects() const;
+
+    void reset();
+
+    std::vector<ObjectStatistics> const& getStatistics() const;
+    std::vector<PatchStatistics> const& getPatchStatistics() const;
+    float getLoad(void* object) const;
+
+    // Sets the profiler that the trampoline on this thread should report to, for the duration of one DSP tick
+    struct ScopedBlock {
+        explicit ScopedBlock(DSPProfiler* profiler)
+        {
+            currentProfiler = profiler;
+        }
+
+        ~ScopedBlock()
+        {
+            currentProfiler = nullptr;
+        }
+    };
+
+private:
+    static constexpr int numHistogramBuckets = 32;
+
+    struct ChainEntry {
+        std::atomic<t_perfroutine> perform = nullptr; // Original perform routine, or nullptr if this slot isn't the start of an instrumented entry
+        std::atomic<uint64> numBlocks = 0;
+        std::atomic<uint64> totalNanos = 0;
+        std::atomic<uint64> minNanos = std::numeric_limits<uint64>::max();
+        std::atomic<uint64> maxNanos = 0;
+        std::atomic<uint32> histogram[numHistogramBuckets] = {}; // Bucket n counts measurements below 2^n nanoseconds
+
+        // Distance to the entry that the perform routine continued with, or 0 if it hasn't run yet
+        // We keep the smallest one we've seen: a prolog of a switched off subpatch jumps over its whole sub-chain
+        std::atomic<int> nextOffset = 0;
+
+        // Only accessed from the message thread
+        t_object* object = nullptr;
+        bool resolved = false;
+        int resolvedOffset = 0;
+        t_glist* segmentPatch = nullptr; // The root patch that runs from this entry up to the next boundary, when measuring patches
+
+        void addMeasurement(uint64 nanos);
+        void clearMeasurements();
+    };
+
+    struct ObjectInfo {
+        String name;
+        std::vector<t_glist*> parents; // From the root canvas down to the patch that contains the object
+    };
+
+    static t_int* profiledPerform(t_int* w);
+    static t_int* patchBoundaryPerform(t_int* w);
+    static DSPProfiler* findProfilerForTrampoline(t_int* w);
+    static DSPProfiler* findProfilerForEntry(t_int* w);
+
+    bool ownsEntry(t_int* w) const;
+    bool registerInstrumentedChain();
+    void unregisterInstrumentedChain();
+
+    void timerCallback() override;
+
+    void instrumentChain();
+    void restoreChain();
+    void resolveEntries();
+    void findObjectParents();
+    void installPatchBoundaries();
+    void updateStatistics();
+
+    Instance* pd;
+    int numUsers = 0;
+    int numObjectUsers = 0;
+    bool measuringObjects = false;
+    bool patchBoundariesInstalled = false;
+
+    // Only accessed from the audio thread, or while holding the audio lock
+    int currentSegment = -1;
+    int64 currentSegmentStart = 0;
+
+    t_int* chain = nullptr;
+    int chainSize = 0;
+    std::unique_ptr<ChainEntry[]> entries;
+    double nanosPerTick = 0.0;
+
+    // The patches that contain each object. Objects with DSP can only be added, removed or moved by rebuilding the DSP chain,
+    // so this only has to be found again when the chain changes
+    std::unordered_map<t_object*, std::vector<t_glist*>> objectParents;
+    bool objectParentsFound = false;
+
+    std::unordered_map<t_object*, ObjectInfo> objectInfo;
+    std::unordered_map<t_glist*, String> rootPatchNames;
+
+    std::vector<ObjectStatistics> statistics;
+    std::vector<PatchStatistics> patchStatistics;
+    std::unordered_map<void*, float> loadPerObject;
+
+    static inline thread_local DSPProfiler* currentProfiler = nullptr;
+
+    // All profilers that currently have trampolines in a DSP chain, so a trampoline can always find its original perform routine
+    static inline std::array<std::atomic<DSPProfiler*>, 64> instrumentedProfilers = {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DSPProfiler)
+};
+
+}
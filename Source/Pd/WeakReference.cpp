@@ -14,56 +14,85 @@ extern "C" {
 #include "WeakReference.h"
 #include "Instance.h"
 
-pd::WeakReference::WeakReference(void* p, Instance* instance)
-    : ptr(p)
-    , pd(instance)
+pd::WeakReferenceTable::~WeakReferenceTable()
 {
-    pd->registerWeakReference(ptr, &weakRef);
+    for (auto& block : blocks) {
+        delete[] block.load();
+    }
 }
 
-pd::WeakReference::WeakReference(Instance* instance)
-    : ptr(nullptr)
-    , pd(instance)
+pd::WeakReferenceTable::Handle pd::WeakReferenceTable::acquire(void* ptr)
 {
-}
+    if (!ptr)
+        return {};
 
-pd::WeakReference::WeakReference(WeakReference const& toCopy)
-    : ptr(toCopy.ptr)
-    , pd(toCopy.pd)
-{
-    pd->weakReferenceMutex.lock();
+    std::lock_guard<std::mutex> lock(mutex);
+
+    uint32 index;
+    if (auto it = slotIndices.find(ptr); it != slotIndices.end()) {
+        index = it->second;
+    } else if (!freeSlots.empty()) {
+        index = freeSlots.back();
+        freeSlots.pop_back();
+        slotIndices.emplace(ptr, index);
+    } else {
+        if (numSlots >= slotsPerBlock * maxBlocks) {
+            jassertfalse; // Out of slots, the reference will never be valid
+            return {};
+        }
 
-    weakRef = toCopy.weakRef.load();
-    pd->registerWeakReference(ptr, &weakRef);
+        index = numSlots++;
+        auto& block = blocks[index / slotsPerBlock];
+        if (!block.load(std::memory_order_relaxed)) {
+            block.store(new Slot[slotsPerBlock], std::memory_order_release);
+        }
+        slotIndices.emplace(ptr, index);
+    }
 
-    pd->weakReferenceMutex.unlock();
+    auto const* block = blocks[index / slotsPerBlock].load(std::memory_order_relaxed);
+    return { index, block[index % slotsPerBlock].generation.load(std::memory_order_relaxed) };
 }
 
-pd::WeakReference::~WeakReference()
+pd::WeakReferenceTable::ExternalReference* pd::WeakReferenceTable::createExternalReference(void* ptr)
 {
-    if (pd)
-        pd->unregisterWeakReference(ptr, &weakRef);
+    auto const handle = acquire(ptr);
+    auto const* block = blocks[handle.index / slotsPerBlock].load(std::memory_order_acquire);
+    return new ExternalReference { block ? &block[handle.index % slotsPerBlock].generation : nullptr, handle.generation };
 }
 
-pd::WeakReference& pd::WeakReference::operator=(pd::WeakReference const& other)
+void pd::WeakReferenceTable::clear(void* ptr)
 {
-    bool valid = other.ptr && other.pd;
-    if (valid && this != &other) // Check for self-assignment
-    {
-        pd = other.pd;
+    std::lock_guard<std::mutex> lock(mutex);
 
-        pd->weakReferenceMutex.lock();
-        pd->unregisterWeakReference(ptr, &other.weakRef);
+    auto it = slotIndices.find(ptr);
+    if (it == slotIndices.end())
+        return;
 
-        // Use atomic exchange to safely copy the weakRef value
-        weakRef.store(other.weakRef.load());
-        ptr = other.ptr;
+    auto const index = it->second;
+    auto& generation = blocks[index / slotsPerBlock].load(std::memory_order_relaxed)[index % slotsPerBlock].generation;
 
-        pd->registerWeakReference(ptr, &weakRef);
-        pd->weakReferenceMutex.unlock();
-    }
+    // Skip 0 when wrapping around, so default handles stay invalid
+    auto newGeneration = generation.load(std::memory_order_relaxed) + 1;
+    if (newGeneration == 0)
+        newGeneration = 1;
+    generation.store(newGeneration, std::memory_order_release);
 
-    return *this;
+    slotIndices.erase(it);
+    freeSlots.push_back(index);
+}
+
+pd::WeakReference::WeakReference(void* p, Instance* instance)
+    : ptr(p)
+    , pd(instance)
+    , table(&instance->weakReferences)
+    , handle(instance->weakReferences.acquire(p))
+{
+}
+
+pd::WeakReference::WeakReference(Instance* instance)
+    : ptr(nullptr)
+    , pd(instance)
+{
 }
 
 void pd::WeakReference::setThis() const
@@ -5,28 +5,78 @@
  */
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <functional>
 #include <unordered_map>
 #include <mutex>
 
 #include <m_pd.h>
 
-using pd_weak_reference = std::atomic<bool>;
-
 namespace pd {
 
+// Keeps track of which pd objects are still alive
+// Every pointer that we hold a reference to gets a slot with a generation counter. When pd frees the object, the generation of its slot
+// is bumped, which invalidates all references to it at once. Checking whether a reference is still valid is a single atomic load.
+// Only creating a reference and freeing an object need the mutex; copying and destroying references is free.
+class WeakReferenceTable {
+public:
+    struct Handle {
+        uint32 index = 0;
+        uint32 generation = 0; // Slots never have generation 0, so a default handle is never valid
+    };
+
+    // Handed out to the C side, which only gets to pass us a single pointer to check the reference
+    struct ExternalReference {
+        std::atomic<uint32> const* generation;
+        uint32 expectedGeneration;
+
+        bool isAlive() const
+        {
+            return generation && generation->load(std::memory_order_acquire) == expectedGeneration;
+        }
+    };
+
+    WeakReferenceTable() = default;
+    ~WeakReferenceTable();
+
+    Handle acquire(void* ptr);
+    ExternalReference* createExternalReference(void* ptr);
+
+    // Called by pd when an object is freed
+    void clear(void* ptr);
+
+    bool isAlive(Handle handle) const
+    {
+        auto const* block = blocks[handle.index / slotsPerBlock].load(std::memory_order_acquire);
+        return block && block[handle.index % slotsPerBlock].generation.load(std::memory_order_acquire) == handle.generation;
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint32> generation = 1;
+    };
+
+    // Slots are allocated in blocks that never move, so readers don't need to lock while the table grows
+    static constexpr uint32 slotsPerBlock = 4096;
+    static constexpr uint32 maxBlocks = 4096;
+
+    std::array<std::atomic<Slot*>, maxBlocks> blocks {};
+
+    std::mutex mutex;
+    std::unordered_map<void*, uint32> slotIndices;
+    std::vector<uint32> freeSlots;
+    uint32 numSlots = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(WeakReferenceTable)
+};
+
 class Instance;
 struct WeakReference {
     WeakReference(void* p, Instance* instance);
 
     WeakReference(Instance* instance);
 
-    WeakReference(WeakReference const& toCopy);
-
-    ~WeakReference();
-
-    WeakReference& operator=(WeakReference const& other);
-
     bool operator==(WeakReference const& other) const
     {
         return ptr == other.ptr;
@@ -39,10 +89,12 @@ struct WeakReference {
 
     void setThis() const;
 
+    // Holds the pd lock for as long as it exists
+    // For traversals over many objects, it's better to take the lock once and use getRaw for each object
     template<typename T>
     struct Ptr {
 
-        Ptr(T* pointer, pd_weak_reference const& ref)
+        Ptr(T* pointer, WeakReference const& ref)
             : weakRef(ref)
             , ptr(pointer)
         {
@@ -54,20 +106,21 @@ struct WeakReference {
             sys_unlock();
         }
 
+        // Checked every time, since the object could be freed while we hold the lock
         operator bool() const
         {
-            return weakRef && (ptr != nullptr);
+            return weakRef.isAlive() && (ptr != nullptr);
         }
 
         T* get()
         {
-            return weakRef ? ptr : nullptr;
+            return weakRef.isAlive() ? ptr : nullptr;
         }
 
         template<typename C>
         C* cast()
         {
-            return weakRef ? reinterpret_cast<C*>(ptr) : nullptr;
+            return weakRef.isAlive() ? reinterpret_cast<C*>(ptr) : nullptr;
         }
 
         T* operator->()
@@ -75,7 +128,7 @@ struct WeakReference {
             return ptr;
         }
 
-        pd_weak_reference const& weakRef;
+        WeakReference const& weakRef;
         T* ptr;
 
         JUCE_DECLARE_NON_COPYABLE(Ptr)
@@ -85,14 +138,15 @@ struct WeakReference {
     Ptr<T> get() const
     {
         setThis();
-        return Ptr<T>(reinterpret_cast<T*>(ptr), weakRef);
+        return Ptr<T>(reinterpret_cast<T*>(ptr), *this);
     }
 
+    // Doesn't lock, so the caller needs to hold the pd lock while using the result
     template<typename T>
     T* getRaw() const
     {
         setThis();
-        return weakRef ? reinterpret_cast<T*>(ptr) : nullptr;
+        return isAlive() ? reinterpret_cast<T*>(ptr) : nullptr;
     }
 
     template<typename T>
@@ -101,15 +155,21 @@ struct WeakReference {
         return reinterpret_cast<T*>(ptr);
     }
 
-    bool isValid()
+    bool isValid() const
     {
-        return weakRef && ptr != nullptr;
+        return isAlive() && ptr != nullptr;
     }
 
 private:
+    bool isAlive() const
+    {
+        return table && table->isAlive(handle);
+    }
+
     void* ptr;
     Instance* pd;
-    pd_weak_reference weakRef = true;
+    WeakReferenceTable const* table = nullptr;
+    WeakReferenceTable::Handle handle;
 };
 
 }
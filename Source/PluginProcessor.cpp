@@ -5,6 +5,7 @@
  */
 #include <clocale>
 #include <memory>
+#include <bit>
 
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_audio_basics/juce_audio_basics.h>
@@ -19,6 +20,7 @@
 #include "Utility/PluginParameter.h"
 #include "Utility/OSUtils.h"
 #include "Utility/AudioSampleRingBuffer.h"
+#include "Utility/RealtimeAudit.h"
 #include "Utility/MidiDeviceManager.h"
 
 #include "Utility/Presets.h"
@@ -100,6 +102,9 @@ PluginProcessor::PluginProcessor()
     }
 
     statusbarSource = std::make_unique<StatusbarSource>();
+    statusbarSource->onMidiEventsDropped = [this](int numDropped) {
+        logWarning("Warning: dropped " + String(numDropped) + " MIDI events, more MIDI was sent at once than fits in the MIDI buffer");
+    };
 
     auto* volumeParameter = new PlugDataParameter(this, "volume", 0.8f, true, 0, 0.0f, 1.0f);
     addParameter(volumeParameter);
@@ -136,9 +141,6 @@ PluginProcessor::PluginProcessor()
     midiBufferOut.ensureSize(2048);
     midiBufferInternalSynth.ensureSize(2048);
 
-    atoms_playhead.reserve(3);
-    atoms_playhead.resize(1);
-
     auto themeName = settingsFile->getProperty<String>("theme");
 
     // Make sure theme exists
@@ -164,6 +166,24 @@ PluginProcessor::PluginProcessor()
     initialisePd(pdlua_version);
     logMessage(pdlua_version);
 
+    // Symbols can only be created once the pd instance exists
+    playheadSymbols.receiver = generateSymbol("_playhead");
+    playheadSymbols.playing = generateSymbol("playing");
+    playheadSymbols.recording = generateSymbol("recording");
+    playheadSymbols.looping = generateSymbol("looping");
+    playheadSymbols.edittime = generateSymbol("edittime");
+    playheadSymbols.framerate = generateSymbol("framerate");
+    playheadSymbols.bpm = generateSymbol("bpm");
+    playheadSymbols.lastbar = generateSymbol("lastbar");
+    playheadSymbols.timesig = generateSymbol("timesig");
+    playheadSymbols.position = generateSymbol("position");
+
+    for (auto* param : getParameters()) {
+        auto* pldParam = reinterpret_cast<PlugDataParameter*>(param);
+        pldParam->updateReceiverSymbol();
+        setParameterDirty(param->getParameterIndex());
+    }
+
     updateSearchPaths();
 
     objectLibrary = std::make_unique<pd::Library>(this);
@@ -509,6 +529,10 @@ void PluginProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
     midiBufferIn.clear();
     midiBufferOut.clear();
 
+    // Preallocate the MIDI buffers, so adding events on the audio thread won't need to allocate
+    midiBufferIn.ensureSize(8192);
+    midiBufferOut.ensureSize(8192);
+
     // If the block size is a multiple of 64 and we are not a plugin, we can optimise the process loop
     // Audio plugins can choose to send in a smaller block size when automation is happening
     variableBlockSize = !ProjectInfo::isStandalone || samplesPerBlock < pdBlockSize || samplesPerBlock % pdBlockSize != 0;
@@ -617,6 +641,7 @@ void PluginProcessor::processBlockBypassed(AudioBuffer<float>& buffer, MidiBuffe
 
 void PluginProcessor::processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiMessages)
 {
+    RealtimeAudit::ScopedAudioThread realtimeAudit;
     ScopedNoDenormals noDenormals;
     AudioProcessLoadMeasurer::ScopedTimer cpuTimer(cpuLoadMeasurer, buffer.getNumSamples());
 
@@ -683,6 +708,9 @@ void PluginProcessor::processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiM
     smoothedGain.applyGain(buffer, buffer.getNumSamples());
 
     statusbarSource->process(hasMidiInEvents, hasMidiOutEvents, totalNumOutputChannels);
+    if (auto const numDropped = getAndResetNumDroppedMidiEvents()) {
+        statusbarSource->addDroppedMidiEvents(numDropped);
+    }
     statusbarSource->setCPUUsage(cpuLoadMeasurer.getLoadAsPercentage());
     statusbarSource->peakBuffer.write(buffer);
 
@@ -850,6 +878,12 @@ void PluginProcessor::processVariable(dsp::AudioBlock<float> buffer, MidiBuffer&
     }
 
     outputFifo->readAudioAndMidi(buffer, midiMessages);
+
+    // Only happens when more MIDI than fits in the fifo comes in at once, like a very large sysex dump
+    // We can't log from the audio thread, so the statusbar timer reports it
+    if (auto const numDropped = inputFifo->getAndResetNumDroppedMidiEvents() + outputFifo->getAndResetNumDroppedMidiEvents()) {
+        statusbarSource->addDroppedMidiEvents(numDropped);
+    }
 }
 
 void PluginProcessor::sendPlayhead()
@@ -860,95 +894,128 @@ void PluginProcessor::sendPlayhead()
         return;
 
     auto infos = playhead->getPosition();
-    
+    if (!infos.hasValue())
+        return;
+
+    t_atom atoms[3];
+    auto send = [this, &atoms](t_symbol* selector, int argc) {
+        // Re-check the receiver for every message, since receiving one of them could make the patch remove the receiver
+        if (auto* receiver = playheadSymbols.receiver->s_thing)
+            pd_typedmess(receiver, selector, argc, atoms);
+    };
+
     lockAudioThread();
     setThis();
-    if (infos.hasValue()) {
-        atoms_playhead[0] = static_cast<float>(infos->getIsPlaying());
-        sendMessage("_playhead", "playing", atoms_playhead);
 
-        atoms_playhead[0] = static_cast<float>(infos->getIsRecording());
-        sendMessage("_playhead", "recording", atoms_playhead);
+    // Most patches don't use the playhead, so don't bother filling in the messages
+    if (!playheadSymbols.receiver->s_thing) {
+        unlockAudioThread();
+        return;
+    }
 
-        atoms_playhead[0] = static_cast<float>(infos->getIsLooping());
+    SETFLOAT(atoms, static_cast<float>(infos->getIsPlaying()));
+    send(playheadSymbols.playing, 1);
 
-        auto loopPoints = infos->getLoopPoints();
-        if (loopPoints.hasValue()) {
-            atoms_playhead.emplace_back(static_cast<float>(loopPoints->ppqStart));
-            atoms_playhead.emplace_back(static_cast<float>(loopPoints->ppqEnd));
-        } else {
-            atoms_playhead.emplace_back(0.0f);
-            atoms_playhead.emplace_back(0.0f);
-        }
-        sendMessage("_playhead", "looping", atoms_playhead);
+    SETFLOAT(atoms, static_cast<float>(infos->getIsRecording()));
+    send(playheadSymbols.recording, 1);
 
-        if (infos->getEditOriginTime().hasValue()) {
-            atoms_playhead.resize(1);
-            atoms_playhead[0] = static_cast<float>(*infos->getEditOriginTime());
-            sendMessage("_playhead", "edittime", atoms_playhead);
-        }
+    auto loopPoints = infos->getLoopPoints();
+    SETFLOAT(atoms, static_cast<float>(infos->getIsLooping()));
+    SETFLOAT(atoms + 1, loopPoints.hasValue() ? static_cast<float>(loopPoints->ppqStart) : 0.0f);
+    SETFLOAT(atoms + 2, loopPoints.hasValue() ? static_cast<float>(loopPoints->ppqEnd) : 0.0f);
+    send(playheadSymbols.looping, 3);
 
-        if (infos->getFrameRate().hasValue()) {
-            atoms_playhead.resize(1);
-            atoms_playhead[0] = static_cast<float>(infos->getFrameRate()->getEffectiveRate());
-            sendMessage("_playhead", "framerate", atoms_playhead);
-        }
+    if (infos->getEditOriginTime().hasValue()) {
+        SETFLOAT(atoms, static_cast<float>(*infos->getEditOriginTime()));
+        send(playheadSymbols.edittime, 1);
+    }
 
-        if (infos->getBpm().hasValue()) {
-            atoms_playhead.resize(1);
-            atoms_playhead[0] = static_cast<float>(*infos->getBpm());
-            sendMessage("_playhead", "bpm", atoms_playhead);
-        }
+    if (infos->getFrameRate().hasValue()) {
+        SETFLOAT(atoms, static_cast<float>(infos->getFrameRate()->getEffectiveRate()));
+        send(playheadSymbols.framerate, 1);
+    }
 
-        if (infos->getPpqPositionOfLastBarStart().hasValue()) {
-            atoms_playhead.resize(1);
-            atoms_playhead[0] = static_cast<float>(*infos->getPpqPositionOfLastBarStart());
-            sendMessage("_playhead", "lastbar", atoms_playhead);
-        }
+    if (infos->getBpm().hasValue()) {
+        SETFLOAT(atoms, static_cast<float>(*infos->getBpm()));
+        send(playheadSymbols.bpm, 1);
+    }
 
-        if (infos->getTimeSignature().hasValue()) {
-            atoms_playhead.resize(1);
-            atoms_playhead[0] = static_cast<float>(infos->getTimeSignature()->numerator);
-            atoms_playhead.emplace_back(static_cast<float>(infos->getTimeSignature()->denominator));
-            sendMessage("_playhead", "timesig", atoms_playhead);
-        }
-        
-        auto ppq = infos->getPpqPosition();
-        auto samplesTime = infos->getTimeInSamples();
-        auto secondsTime = infos->getTimeInSeconds();
-        if (ppq.hasValue() || samplesTime.hasValue() || secondsTime.hasValue()) {
-            atoms_playhead.resize(3);
-            atoms_playhead[0] = ppq.hasValue() ? static_cast<float>(*ppq) : 0.0f;
-            atoms_playhead[1] = samplesTime.hasValue() ? static_cast<float>(*samplesTime) : 0.0f;
-            atoms_playhead[2] = secondsTime.hasValue() ? static_cast<float>(*secondsTime) : 0.0f;
-            sendMessage("_playhead", "position", atoms_playhead);
-        }
-        atoms_playhead.resize(1);
+    if (infos->getPpqPositionOfLastBarStart().hasValue()) {
+        SETFLOAT(atoms, static_cast<float>(*infos->getPpqPositionOfLastBarStart()));
+        send(playheadSymbols.lastbar, 1);
     }
+
+    if (infos->getTimeSignature().hasValue()) {
+        SETFLOAT(atoms, static_cast<float>(infos->getTimeSignature()->numerator));
+        SETFLOAT(atoms + 1, static_cast<float>(infos->getTimeSignature()->denominator));
+        send(playheadSymbols.timesig, 2);
+    }
+
+    auto ppq = infos->getPpqPosition();
+    auto samplesTime = infos->getTimeInSamples();
+    auto secondsTime = infos->getTimeInSeconds();
+    if (ppq.hasValue() || samplesTime.hasValue() || secondsTime.hasValue()) {
+        SETFLOAT(atoms, ppq.hasValue() ? static_cast<float>(*ppq) : 0.0f);
+        SETFLOAT(atoms + 1, samplesTime.hasValue() ? static_cast<float>(*samplesTime) : 0.0f);
+        SETFLOAT(atoms + 2, secondsTime.hasValue() ? static_cast<float>(*secondsTime) : 0.0f);
+        send(playheadSymbols.position, 3);
+    }
+
     unlockAudioThread();
 }
 
+void PluginProcessor::setParameterDirty(int parameterIndex)
+{
+    dirtyParameters[parameterIndex / 64].fetch_or(uint64(1) << (parameterIndex % 64), std::memory_order_release);
+}
+
 void PluginProcessor::sendParameters()
 {
-    for (auto* param : getParameters()) {
-        // We used to do dynamic_cast here, but since it gets called very often and param is always PlugDataParameter, we use reinterpret_cast now
-        auto* pldParam = reinterpret_cast<PlugDataParameter*>(param);
-        if (!pldParam->isEnabled())
-            continue;
+    auto const& parameters = getParameters();
+    bool isLocked = false;
+
+    for (size_t word = 0; word < dirtyParameters.size(); word++) {
+        auto dirty = dirtyParameters[word].exchange(0, std::memory_order_acquire);
+        while (dirty) {
+            auto const bit = std::countr_zero(dirty);
+            dirty &= dirty - 1;
+
+            // We used to do dynamic_cast here, but since it gets called very often and param is always PlugDataParameter, we use reinterpret_cast now
+            auto* pldParam = reinterpret_cast<PlugDataParameter*>(parameters[static_cast<int>(word * 64) + bit]);
+            if (!pldParam || !pldParam->isEnabled())
+                continue;
 
-        auto newvalue = pldParam->getUnscaledValue();
-        if (!approximatelyEqual(pldParam->getLastValue(), newvalue)) {
-            auto title = pldParam->getTitle();
-            sendFloat(title.toRawUTF8(), pldParam->getUnscaledValue());
-            pldParam->setLastValue(newvalue);
+            auto newvalue = pldParam->getUnscaledValue();
+            if (!approximatelyEqual(pldParam->getLastValue(), newvalue)) {
+                // Only take the pd lock if there is something to send, like libpd_float would
+                if (!isLocked) {
+                    setThis();
+                    sys_lock();
+                    isLocked = true;
+                }
+
+                if (auto* receiver = pldParam->getReceiverSymbol(); receiver && receiver->s_thing) {
+                    pd_float(receiver->s_thing, newvalue);
+                }
+                pldParam->setLastValue(newvalue);
+            }
         }
     }
+
+    if (isLocked)
+        sys_unlock();
 }
 
 void PluginProcessor::sendMidiBuffer()
+{
+    sendMidiBuffer(midiBufferIn);
+    midiBufferIn.clear();
+}
+
+void PluginProcessor::sendMidiBuffer(MidiBuffer const& buffer)
 {
     if (acceptsMidi()) {
-        for (auto const& event : midiBufferIn) {
+        for (auto const& event : buffer) {
 
             int device;
             auto message = MidiDeviceManager::convertFromSysExFormat(event.getMessage(), device);
@@ -983,7 +1050,6 @@ void PluginProcessor::sendMidiBuffer()
                 sendMidiByte(device, static_cast<int>(message.getRawData()[i]));
             }
         }
-        midiBufferIn.clear();
     }
 }
 
@@ -1011,41 +1077,22 @@ void PluginProcessor::getStateInformation(MemoryBlock& destData)
 {
     setThis();
 
-    // Store pure-data and parameter state
-    MemoryOutputStream ostream(destData, false);
-
-    ostream.writeInt(patches.size());
-
-    // Save path and content for patch
-    lockAudioThread();
-
-    auto presetDir = ProjectInfo::appDataDir.getChildFile("Extra").getChildFile("Presets");
-
     auto patchesTree = new XmlElement("Patches");
 
-    for (auto const& patch : patches) {
-
-        auto content = patch->getCanvasContent();
-        auto patchFile = patch->getCurrentFile().getFullPathName();
-
-        // Write legacy format
-        ostream.writeString(content);
-        ostream.writeString(patchFile);
-
+    // Hosts can call this on every save or undo, so we don't hold the audio lock for the whole state
+    // Each patch only locks the audio thread while it checks for changes, and while reading its content if it did change
+    auto const patchesToSave = patches;
+    for (auto const& patch : patchesToSave) {
         auto* patchTree = new XmlElement("Patch");
-        // Write new format
-        patchTree->setAttribute("Content", content);
-        patchTree->setAttribute("Location", patchFile);
+        patchTree->setAttribute("Location", patch->getCurrentFile().getFullPathName());
         patchTree->setAttribute("PluginMode", patch->openInPluginMode);
         patchTree->setAttribute("SplitIndex", patch->splitViewIndex);
 
+        // Stored as text instead of an attribute, so the newlines don't need to be escaped
+        patchTree->addTextElement(patch->getContentSnapshot());
+
         patchesTree->addChildElement(patchTree);
     }
-    unlockAudioThread();
-
-    ostream.writeInt(getLatencySamples() - Instance::getBlockSize());
-    ostream.writeInt(oversampling);
-    ostream.writeFloat(getValue<float>(tailLength));
 
     auto xml = XmlElement("plugdata_save");
     xml.setAttribute("Version", PLUGDATA_VERSION);
@@ -1079,11 +1126,14 @@ void PluginProcessor::getStateInformation(MemoryBlock& destData)
         }
     }
 
-    MemoryBlock xmlBlock;
-    copyXmlToBinary(xml, xmlBlock);
+    MemoryOutputStream ostream(destData, false);
+    ostream.writeInt(stateFormatMagic);
+    ostream.writeInt(stateFormatVersion);
 
-    ostream.writeInt(static_cast<int>(xmlBlock.getSize()));
-    ostream.write(xmlBlock.getData(), xmlBlock.getSize());
+    {
+        GZIPCompressorOutputStream compressor(ostream);
+        xml.writeTo(compressor, XmlElement::TextFormat().withoutHeader().singleLine());
+    }
 
     // then detach extraData XmlElement from temporary tree xml for later re-use
     if (extraDataStored) {
@@ -1098,6 +1148,44 @@ void PluginProcessor::setStateInformation(void const* data, int sizeInBytes)
 
     MemoryInputStream istream(data, sizeInBytes, false);
 
+    // Parse the state before locking the audio thread
+    std::unique_ptr<XmlElement> xmlState;
+    Array<std::pair<String, File>> legacyPatches;
+    int legacyLatency = 0;
+    int legacyOversampling = 0;
+    float legacyTail = 0.0f;
+
+    if (istream.readInt() == stateFormatMagic) {
+        istream.readInt(); // Format version, there is only one so far
+
+        GZIPDecompressorInputStream decompressor(istream);
+        xmlState = parseXML(decompressor.readEntireStreamAsString());
+    } else {
+        // Legacy format: the patches and settings are stored twice, in a binary stream and in an XML block
+        istream.setPosition(0);
+
+        int numPatches = istream.readInt();
+        for (int i = 0; i < numPatches; i++) {
+            auto state = istream.readString();
+            auto path = istream.readString();
+
+            auto presetDir = ProjectInfo::appDataDir.getChildFile("Extra").getChildFile("Presets");
+            path = path.replace("${PRESET_DIR}", presetDir.getFullPathName());
+            legacyPatches.add({ state, File(path) });
+        }
+
+        legacyLatency = istream.readInt();
+        legacyOversampling = istream.readInt();
+        legacyTail = istream.readFloat();
+
+        auto xmlSize = istream.readInt();
+
+        MemoryBlock xmlData;
+        istream.readIntoMemoryBlock(xmlData, xmlSize);
+
+        xmlState = getXmlFromBinary(xmlData.getData(), static_cast<int>(xmlData.getSize()));
+    }
+
     lockAudioThread();
 
     setThis();
@@ -1116,43 +1204,16 @@ void PluginProcessor::setStateInformation(void const* data, int sizeInBytes)
         }
     }
     
-    int numPatches = istream.readInt();
-
-    Array<std::pair<String, File>> patches;
-
-    for (int i = 0; i < numPatches; i++) {
-        auto state = istream.readString();
-        auto path = istream.readString();
-
-        auto presetDir = ProjectInfo::appDataDir.getChildFile("Extra").getChildFile("Presets");
-        path = path.replace("${PRESET_DIR}", presetDir.getFullPathName());
-        patches.add({ state, File(path) });
-    }
-
-    auto legacyLatency = istream.readInt();
-    auto legacyOversampling = istream.readInt();
-    auto legacyTail = istream.readFloat();
-
-    auto xmlSize = istream.readInt();
-
-    auto* xmlData = new char[xmlSize];
-    istream.read(xmlData, xmlSize);
-
-    std::unique_ptr<XmlElement> xmlState(getXmlFromBinary(xmlData, xmlSize));
-
     auto openPatch = [this](String const& content, File const& location, bool pluginMode = false, int splitIndex = 0) {
         // CHANGED IN v0.9.0:
         // We now prefer loading the patch content over the patch file, if possible
         // This generally makes it work more like the users expect, but before we couldn't get it to load abstractions (this is now fixed)
         if (content.isNotEmpty()) {
             auto locationIsValid = location.getParentDirectory().exists() && location.getFullPathName().isNotEmpty();
-            // Force pd to use this path for the next opened patch
+
+            // Open the patch as if it was loaded from its saved location
             // This makes sure the patch can find abstractions/resources, even though it's loading a patch from state
-            if(locationIsValid) {
-                glob_forcefilename(generateSymbol(location.getFileName().toRawUTF8()), generateSymbol(location.getParentDirectory().getFullPathName().replaceCharacter('\\', '/').toRawUTF8()));
-            }
-            
-            auto patchPtr = loadPatch(content);
+            auto patchPtr = loadPatch(content, locationIsValid ? location : File());
             patchPtr->splitViewIndex = splitIndex;
             patchPtr->openInPluginMode = pluginMode;
             if (!locationIsValid || location.getParentDirectory() == File::getSpecialLocation(File::tempDirectory)) {
@@ -1172,7 +1233,8 @@ void PluginProcessor::setStateInformation(void const* data, int sizeInBytes)
         // If xmltree contains new patch format, use that
         if (auto* patchTree = xmlState->getChildByName("Patches")) {
             for (auto p : patchTree->getChildWithTagNameIterator("Patch")) {
-                auto content = p->getStringAttribute("Content");
+                // Before the compressed state format, the content was stored as an attribute
+                auto content = p->hasAttribute("Content") ? p->getStringAttribute("Content") : p->getAllSubText();
                 auto location = p->getStringAttribute("Location");
                 auto pluginMode = p->getBoolAttribute("PluginMode");
 
@@ -1189,7 +1251,7 @@ void PluginProcessor::setStateInformation(void const* data, int sizeInBytes)
         }
         // Otherwise, load from legacy format
         else {
-            for (auto& [content, location] : patches) {
+            for (auto& [content, location] : legacyPatches) {
                 openPatch(content, location);
             }
         }
@@ -1235,8 +1297,6 @@ void PluginProcessor::setStateInformation(void const* data, int sizeInBytes)
     }
 
     unlockAudioThread();
-    
-    delete[] xmlData;
 
     
     if (auto* editor = dynamic_cast<PluginEditor*>(getActiveEditor())) {
@@ -1252,32 +1312,24 @@ pd::Patch::Ptr PluginProcessor::loadPatch(URL const& patchURL)
 {
     auto patchFile = patchURL.getLocalFile();
 
-    lockAudioThread();
-
 #if JUCE_IOS
-    auto tempFile = File::createTempFile(".pd");
-    auto patchContent = patchFile.loadFileAsString();
-
+    // On iOS, we can only read the patch through the URL, so we open it from its content instead of letting pd read the file
     auto inputStream = patchURL.createInputStream(URL::InputStreamOptions(URL::ParameterHandling::inAddress));
-    tempFile.appendText(inputStream->readEntireStreamAsString());
+    auto patchContent = inputStream ? inputStream->readEntireStreamAsString() : String();
 
-    auto dirname = patchFile.getParentDirectory().getFullPathName().replace("\\", "/");
-    auto filename = patchFile.getFileName();
+    lockAudioThread();
+    auto newPatch = openPatch(patchContent, patchFile);
+    unlockAudioThread();
 
-    if(!glob_hasforcedfilename()) {
-        glob_forcefilename(generateSymbol(filename), generateSymbol(dirname));
-    }
-    auto newPatch = openPatch(tempFile);
-    if (newPatch) {
-        if (auto patch = newPatch->getPointer()) {
-            newPatch->setTitle(filename);
-            newPatch->setCurrentFile(patchURL);
-        }
+    if (auto patch = newPatch->getPointer()) {
+        newPatch->setTitle(patchFile.getFileName());
+        newPatch->setCurrentFile(patchURL);
     }
 #else
+    lockAudioThread();
     auto newPatch = openPatch(patchFile);
-#endif
     unlockAudioThread();
+#endif
 
     if (!newPatch->getPointer()) {
         logError("Couldn't open patch");
@@ -1291,17 +1343,28 @@ pd::Patch::Ptr PluginProcessor::loadPatch(URL const& patchURL)
     return patch;
 }
 
-pd::Patch::Ptr PluginProcessor::loadPatch(String patchText)
+pd::Patch::Ptr PluginProcessor::loadPatch(String patchText, File const& location)
 {
     if (patchText.isEmpty())
         patchText = pd::Instance::defaultPatch;
 
-    auto patchFile = File::createTempFile(".pd");
-    patchFile.replaceWithText(patchText);
+    // The patch text is evaluated directly, so nothing is written to disk
+    // Patches without a location are opened as if they were in the temp directory
+    auto const patchFile = location.getFullPathName().isNotEmpty() ? location : File::getSpecialLocation(File::tempDirectory).getChildFile("Untitled.pd");
+
+    lockAudioThread();
+    auto newPatch = openPatch(patchText, patchFile);
+    unlockAudioThread();
+
+    if (!newPatch->getPointer()) {
+        logError("Couldn't open patch");
+        return nullptr;
+    }
 
-    auto patch = loadPatch(URL(patchFile));
+    patches.add(newPatch);
+    auto* patch = patches.getLast().get();
 
-    // Set to unknown file when loading temp patch
+    // Set to unknown file when loading from text
     patch->setCurrentFile(URL("file://"));
 
     return patch;
@@ -116,8 +116,10 @@ public:
     void updateSearchPaths();
 
     void sendMidiBuffer();
+    void sendMidiBuffer(MidiBuffer const& buffer);
     void sendPlayhead();
     void sendParameters();
+    void setParameterDirty(int parameterIndex);
 
     Array<PluginEditor*> getEditors() const;
 
@@ -133,7 +135,7 @@ public:
     void parseDataBuffer(XmlElement const& xml) override;
     std::unique_ptr<XmlElement> extraData;
 
-    pd::Patch::Ptr loadPatch(String patch);
+    pd::Patch::Ptr loadPatch(String patch, File const& location = File());
     pd::Patch::Ptr loadPatch(URL const& patchURL);
 
     void titleChanged() override;
@@ -177,6 +179,10 @@ public:
     Component::SafePointer<ConnectionMessageDisplay> connectionListener;
 
 private:
+    // DAW states start with this, followed by the version and the compressed XML state
+    // It's negative so it can't be confused with the patch count that legacy states start with
+    static constexpr int stateFormatMagic = -0x70647374;
+    static constexpr int stateFormatVersion = 1;
 
     int customLatencySamples = 0;
 
@@ -205,7 +211,23 @@ private:
     uint8 midiByteBuffer[512] = { 0 };
     size_t midiByteIndex = 0;
 
-    std::vector<pd::Atom> atoms_playhead;
+    // Receivers for the playhead messages, looked up once so sendPlayhead doesn't have to hash them on every block
+    struct PlayheadSymbols {
+        t_symbol* receiver = nullptr;
+        t_symbol* playing = nullptr;
+        t_symbol* recording = nullptr;
+        t_symbol* looping = nullptr;
+        t_symbol* edittime = nullptr;
+        t_symbol* framerate = nullptr;
+        t_symbol* bpm = nullptr;
+        t_symbol* lastbar = nullptr;
+        t_symbol* timesig = nullptr;
+        t_symbol* position = nullptr;
+    } playheadSymbols;
+
+    // One bit per parameter (including volume) that changed since the last block
+    // These get set from whichever thread the host changes parameters on, and sendParameters only looks at the parameters that have their bit set
+    std::array<std::atomic<uint64>, (numParameters + 1 + 63) / 64> dirtyParameters {};
 
     int lastSetProgram = 0;
 
@@ -0,0 +1,204 @@
+/*
+ // Copyright (c) 2021-2022 Timothy Schoen.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include "Pd/Profiler.h"
+
+// Sidebar panel that shows the DSP profiler results for every object, sortable by each column
+class ProfilerPanel : public Component
+    , public TableListBoxModel
+    , public ChangeListener {
+
+    enum Column {
+        ObjectColumn = 1,
+        AverageColumn,
+        MinimumColumn,
+        MaximumColumn,
+        PercentileColumn,
+        LoadColumn
+    };
+
+public:
+    explicit ProfilerPanel(PluginEditor* pluginEditor)
+        : editor(pluginEditor)
+        , profiler(*pluginEditor->pd->dspProfiler)
+    {
+        auto& header = table.getHeader();
+        header.addColumn("Object", ObjectColumn, 110, 50, -1, TableHeaderComponent::defaultFlags);
+        header.addColumn("Avg", AverageColumn, 48, 40, -1, TableHeaderComponent::defaultFlags);
+        header.addColumn("Min", MinimumColumn, 48, 40, -1, TableHeaderComponent::defaultFlags);
+        header.addColumn("Max", MaximumColumn, 48, 40, -1, TableHeaderComponent::defaultFlags);
+        header.addColumn("P95", PercentileColumn, 48, 40, -1, TableHeaderComponent::defaultFlags);
+        header.addColumn("Load", LoadColumn, 48, 40, -1, TableHeaderComponent::defaultFlags);
+        header.setSortColumnId(AverageColumn, false);
+        header.setStretchToFitActive(true);
+
+        table.setModel(this);
+        table.setRowHeight(24);
+        table.setColour(ListBox::backgroundColourId, Colours::transparentBlack);
+        table.setTooltip("Time per DSP block in microseconds. Click an object to show it in its patch");
+        addAndMakeVisible(table);
+    }
+
+    ~ProfilerPanel() override
+    {
+        if (isProfiling) {
+            profiler.removeChangeListener(this);
+            profiler.removeUser();
+        }
+    }
+
+    void visibilityChanged() override
+    {
+        // Only instrument the DSP chain while the results are visible
+        if (isVisible() && !isProfiling) {
+            profiler.addUser();
+            profiler.addChangeListener(this);
+            isProfiling = true;
+        } else if (!isVisible() && isProfiling) {
+            profiler.removeChangeListener(this);
+            profiler.removeUser();
+            isProfiling = false;
+        }
+    }
+
+    void changeListenerCallback(ChangeBroadcaster* source) override
+    {
+        rows = profiler.getStatistics();
+        sortRows();
+        table.updateContent();
+        table.repaint();
+    }
+
+    int getNumRows() override
+    {
+        return static_cast<int>(rows.size());
+    }
+
+    void sortOrderChanged(int newSortColumnId, bool isForwards) override
+    {
+        sortRows();
+        table.updateContent();
+        table.repaint();
+    }
+
+    void paintRowBackground(Graphics& g, int rowNumber, int width, int height, bool rowIsSelected) override
+    {
+        if (rowIsSelected) {
+            g.setColour(findColour(PlugDataColour::sidebarActiveBackgroundColourId));
+            g.fillRoundedRectangle(Rectangle<float>(0, 0, width, height).reduced(2.0f, 1.0f), Corners::defaultCornerRadius);
+        }
+    }
+
+    void paintCell(Graphics& g, int rowNumber, int columnId, int width, int height, bool rowIsSelected) override
+    {
+        if (!isPositiveAndBelow(rowNumber, rows.size()))
+            return;
+
+        auto const& row = rows[rowNumber];
+        auto colour = findColour(PlugDataColour::sidebarTextColourId);
+        auto bounds = Rectangle<int>(0, 0, width, height).reduced(4, 0);
+
+        switch (columnId) {
+        case ObjectColumn: {
+            Fonts::drawFittedText(g, row.name, bounds, row.object ? colour : colour.withAlpha(0.5f), 1, 0.9f, 13.0f);
+            break;
+        }
+        case AverageColumn: {
+            Fonts::drawText(g, String(row.average, 1), bounds, colour, 13, Justification::centredRight);
+            break;
+        }
+        case MinimumColumn: {
+            Fonts::drawText(g, String(row.minimum, 1), bounds, colour, 13, Justification::centredRight);
+            break;
+        }
+        case MaximumColumn: {
+            Fonts::drawText(g, String(row.maximum, 1), bounds, colour, 13, Justification::centredRight);
+            break;
+        }
+        case PercentileColumn: {
+            Fonts::drawText(g, String(row.percentile, 1), bounds, colour, 13, Justification::centredRight);
+            break;
+        }
+        case LoadColumn: {
+            Fonts::drawText(g, String(row.load * 100.0f, 1) + "%", bounds, colour, 13, Justification::centredRight);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    void cellClicked(int rowNumber, int columnId, MouseEvent const& e) override
+    {
+        if (isPositiveAndBelow(rowNumber, rows.size()) && rows[rowNumber].object) {
+            editor->highlightSearchTarget(rows[rowNumber].object, true);
+        }
+    }
+
+    void paint(Graphics& g) override
+    {
+        g.setColour(findColour(PlugDataColour::sidebarBackgroundColourId));
+        g.fillRect(getLocalBounds());
+    }
+
+    void resized() override
+    {
+        table.setBounds(getLocalBounds());
+    }
+
+    std::unique_ptr<Component> getExtraSettingsComponent()
+    {
+        auto* resetButton = new SmallIconButton(Icons::Reset);
+        resetButton->setTooltip("Reset profiler measurements");
+        resetButton->setConnectedEdges(12);
+        resetButton->onClick = [this]() {
+            profiler.reset();
+        };
+
+        return std::unique_ptr<TextButton>(resetButton);
+    }
+
+private:
+    void sortRows()
+    {
+        auto const columnId = table.getHeader().getSortColumnId();
+        auto const forwards = table.getHeader().isSortedForwards();
+
+        auto getSortValue = [columnId](pd::DSPProfiler::ObjectStatistics const& row) -> double {
+            switch (columnId) {
+            case MinimumColumn:
+                return row.minimum;
+            case MaximumColumn:
+                return row.maximum;
+            case PercentileColumn:
+                return row.percentile;
+            case LoadColumn:
+                return row.load;
+            default:
+                return row.average;
+            }
+        };
+
+        std::stable_sort(rows.begin(), rows.end(), [columnId, forwards, &getSortValue](auto const& a, auto const& b) {
+            if (columnId == ObjectColumn) {
+                auto const compare = a.name.compareNatural(b.name);
+                return forwards ? compare < 0 : compare > 0;
+            }
+            return forwards ? getSortValue(a) < getSortValue(b) : getSortValue(a) > getSortValue(b);
+        });
+    }
+
+    PluginEditor* editor;
+    pd::DSPProfiler& profiler;
+
+    TableListBox table;
+    std::vector<pd::DSPProfiler::ObjectStatistics> rows;
+    bool isProfiling = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ProfilerPanel)
+};
@@ -121,6 +121,7 @@ public:
 
     void clear()
     {
+        patchTrees.clear();
         patchTree.clearValueTree();
     }
 
@@ -129,7 +130,6 @@ public:
         auto* cnv = editor->getCurrentCanvas();
         if (cnv && (currentCanvas.getComponent() != cnv || cnv->needsSearchUpdate)) {
             currentCanvas = cnv;
-            currentCanvas->needsSearchUpdate = false;
             updateResults();
         }
     }
@@ -189,13 +189,30 @@ public:
     void updateResults()
     {
         auto* cnv = editor->getCurrentCanvas();
-        if (cnv) {
-            cnv->pd->lockAudioThread(); // It locks inside of this anyway, so we might as well lock around it to prevent constantly locking/unlocking
-            auto tree = generatePatchTree(cnv->refCountedPatch);
-            patchTree.setValueTree(tree);
-            patchTree.filterNodes();
-            cnv->pd->unlockAudioThread();
+        if (!cnv)
+            return;
+
+        // Forget the trees of canvases that were closed
+        patchTrees.erase(std::remove_if(patchTrees.begin(), patchTrees.end(), [](auto const& entry) { return !entry.canvas; }), patchTrees.end());
+
+        auto it = std::find_if(patchTrees.begin(), patchTrees.end(), [cnv](auto const& entry) { return entry.canvas.getComponent() == cnv; });
+        if (it == patchTrees.end()) {
+            patchTrees.push_back({ cnv, ValueTree(), {} });
+            it = patchTrees.end() - 1;
+            cnv->needsSearchUpdate = true;
+        }
+
+        // Switching back to a canvas that didn't change since we last saw it doesn't need to touch pd at all
+        if (cnv->needsSearchUpdate) {
+            cnv->needsSearchUpdate = false;
+            if (auto patch = cnv->patch.getPointer()) {
+                it->tree = generatePatchTree(patch.get(), it->tree, it->elements);
+            }
         }
+
+        // Updating the tree view is by far the slowest part, so we do that after releasing the pd lock
+        patchTree.setValueTree(it->tree);
+        patchTree.filterNodes();
     }
 
     void grabFocus()
@@ -214,263 +231,384 @@ public:
         patchTree.setBounds(tableBounds);
     }
 
-    ValueTree generatePatchTree(pd::Patch::Ptr patch, void* topLevel = nullptr)
+    // The element we made for an object at the last scan, and a summary of the pd state it was made from
+    struct CachedElement {
+        uint64 signature;
+        ValueTree element;
+    };
+    using ElementCache = std::unordered_map<t_gobj*, CachedElement>;
+
+    // The caller needs to hold the pd lock: we take it once for the whole patch, instead of once for every object
+    // Objects that didn't change since the previous tree was made reuse their element from it, so we only format the text of objects that changed
+    static ValueTree generatePatchTree(t_glist* patch, ValueTree& previousTree, ElementCache& elements)
     {
+        // Take the cached elements out of the previous tree, so they can be added to the new one
+        detachChildren(previousTree);
+
         ValueTree patchTree("Patch");
-        for (auto objectPtr : patch->getObjects()) {
-            if (auto object = objectPtr.get<t_pd>()) {
-                auto* top = topLevel ? topLevel : object.get();
-                String type = String::fromUTF8(pd::Interface::getObjectClassName(object.get()));
+        ElementCache usedElements;
+        addPatchObjects(patchTree, patch, elements, usedElements, nullptr);
+
+        // Objects that no longer exist are left behind here
+        elements = std::move(usedElements);
+        return patchTree;
+    }
 
-                if (!pd::Interface::checkObject(object.get()))
+    static void detachChildren(ValueTree& tree)
+    {
+        for (auto child : tree)
+            detachChildren(child);
+
+        tree.removeAllChildren(nullptr);
+    }
+
+    // Hashes the things that the search element of an object is made from, or returns 0 if the element has to be made every time
+    // That's the case for subpatches, since their contents can change, and for objects that keep their send and receive symbols outside of their text
+    static uint64 getSearchSignature(t_glist* patch, t_gobj* gobj, t_object* object, char const* className)
+    {
+        switch (hash(className)) {
+        case hash("canvas"):
+        case hash("graph"):
+        case hash("bng"):
+        case hash("hsl"):
+        case hash("vsl"):
+        case hash("slider"):
+        case hash("tgl"):
+        case hash("nbx"):
+        case hash("vradio"):
+        case hash("hradio"):
+        case hash("vu"):
+        case hash("cnv"):
+        case hash("keyboard"):
+        case hash("pic"):
+        case hash("scope~"):
+        case hash("function"):
+        case hash("note"):
+        case hash("knob"):
+        case hash("gatom"):
+            return 0;
+        default:
+            break;
+        }
+
+        uint64 signature = 14695981039346656037ull;
+        auto combine = [&signature](uint64 value) {
+            signature = (signature ^ value) * 1099511628211ull;
+        };
+
+        int x, y, w, h;
+        pd::Interface::getObjectBounds(patch, gobj, &x, &y, &w, &h);
+        combine(reinterpret_cast<uint64>(object->te_g.g_pd));
+        combine(static_cast<uint32>(x));
+        combine(static_cast<uint32>(y));
+        combine(static_cast<uint32>(object->te_type));
+
+        if (object->te_binbuf) {
+            auto const numAtoms = binbuf_getnatom(object->te_binbuf);
+            auto const* atoms = binbuf_getvec(object->te_binbuf);
+            combine(static_cast<uint32>(numAtoms));
+            for (int i = 0; i < numAtoms; i++) {
+                combine(static_cast<uint32>(atoms[i].a_type));
+                switch (atoms[i].a_type) {
+                case A_FLOAT: {
+                    uint32 bits;
+                    std::memcpy(&bits, &atoms[i].a_w.w_float, sizeof(bits));
+                    combine(bits);
+                    break;
+                }
+                case A_SYMBOL:
+                case A_DOLLSYM:
+                    combine(reinterpret_cast<uint64>(atoms[i].a_w.w_symbol));
+                    break;
+                case A_DOLLAR:
+                    combine(static_cast<uint32>(atoms[i].a_w.w_index));
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+
+        return signature ? signature : 1;
+    }
+
+    static void addPatchObjects(ValueTree& patchTree, t_glist* patch, ElementCache& previousElements, ElementCache& usedElements, void* topLevel)
+    {
+        for (t_gobj* gobj = patch->gl_list; gobj; gobj = gobj->g_next) {
+            auto* top = topLevel ? topLevel : gobj;
+            auto const* className = pd::Interface::getObjectClassName(&gobj->g_pd);
+
+            auto* object = pd::Interface::checkObject(gobj);
+            if (!object)
+                continue;
+
+            auto const signature = getSearchSignature(patch, gobj, object, className);
+            if (signature) {
+                auto cached = previousElements.find(gobj);
+                if (cached != previousElements.end() && cached->second.signature == signature) {
+                    patchTree.appendChild(cached->second.element, nullptr);
+                    usedElements.emplace(gobj, std::move(cached->second));
                     continue;
+                }
+            }
+
+            auto element = createObjectElement(patch, gobj, object, String::fromUTF8(className), top, previousElements, usedElements);
+            if (signature)
+                usedElements.emplace(gobj, CachedElement { signature, element });
+
+            patchTree.appendChild(element, nullptr);
+        }
+    }
 
-                char* objectText;
-                int len;
-                pd::Interface::getObjectText(object.cast<t_text>(), &objectText, &len);
-
-                int x, y, w, h;
-                pd::Interface::getObjectBounds(patch->getPointer().get(), object.cast<t_gobj>(), &x, &y, &w, &h);
-
-                auto name = String::fromUTF8(objectText, len);
-                auto nameWithoutArgs = name.upToFirstOccurrenceOf(" ", false, false);
-                auto positionText = " (" + String(x) + ":" + String(y) + ")";
-
-                auto getFirstArgumentFromFullName = [](String const& fullName) -> String {
-                    return fullName.fromFirstOccurrenceOf(" ", false, true).upToFirstOccurrenceOf(" ", false, true);
-                };
-
-                ValueTree element("Object");
-                if (type == "canvas" || type == "graph") {
-                    pd::Patch::Ptr subpatch = new pd::Patch(objectPtr, editor->pd, false);
-                    ValueTree subpatchTree = generatePatchTree(subpatch, top);
-                    element.copyPropertiesAndChildrenFrom(subpatchTree, nullptr);
-
-                    if (auto patchPtr = subpatch->getPointer()) {
-                        if (patchPtr->gl_list) {
-                            t_class* c = patchPtr->gl_list->g_pd;
-                            if (c && c->c_name && (String::fromUTF8(c->c_name->s_name) == "array")) {
-                                StringArray arrays;
-                                auto arrayIt = patchPtr->gl_list;
-                                while (arrayIt) {
-                                    if (auto* array = reinterpret_cast<t_fake_garray*>(arrayIt))
-                                        arrays.add(String::fromUTF8(array->x_name->s_name));
-                                    arrayIt = arrayIt->g_next;
-                                }
-                                String formatedArraysText;
-                                for (int i = 0; i < arrays.size(); i++) {
-                                    formatedArraysText += arrays[i] + String(i < arrays.size() - 1 ? ", " : "");
-                                }
-                                name = "array: " + formatedArraysText;
-                            } else if (patchPtr->gl_isgraph) {
-                                name = nameWithoutArgs;
-                            }
-                        } else if (patchPtr->gl_isgraph) {
-                            name = nameWithoutArgs;
-                        }
+    static ValueTree createObjectElement(t_glist* patch, t_gobj* gobj, t_object* object, String const& type, void* top, ElementCache& previousElements, ElementCache& usedElements)
+    {
+        char* objectText;
+        int len;
+        pd::Interface::getObjectText(object, &objectText, &len);
+
+        int x, y, w, h;
+        pd::Interface::getObjectBounds(patch, gobj, &x, &y, &w, &h);
+
+        auto name = String::fromUTF8(objectText, len);
+        auto nameWithoutArgs = name.upToFirstOccurrenceOf(" ", false, false);
+        auto positionText = " (" + String(x) + ":" + String(y) + ")";
+
+        auto getFirstArgumentFromFullName = [](String const& fullName) -> String {
+            return fullName.fromFirstOccurrenceOf(" ", false, true).upToFirstOccurrenceOf(" ", false, true);
+        };
+
+        ValueTree element("Object");
+        if (type == "canvas" || type == "graph") {
+            auto* subpatch = reinterpret_cast<t_glist*>(gobj);
+            addPatchObjects(element, subpatch, previousElements, usedElements, top);
+
+            if (subpatch->gl_list) {
+                t_class* c = subpatch->gl_list->g_pd;
+                if (c && c->c_name && (String::fromUTF8(c->c_name->s_name) == "array")) {
+                    StringArray arrays;
+                    auto arrayIt = subpatch->gl_list;
+                    while (arrayIt) {
+                        if (auto* array = reinterpret_cast<t_fake_garray*>(arrayIt))
+                            arrays.add(String::fromUTF8(array->x_name->s_name));
+                        arrayIt = arrayIt->g_next;
                     }
-#ifdef SHOW_PD_SUBPATCH_SYMBOL
-                    if (nameWithoutArgs == "pd") {
-                        auto arg = getFirstArgumentFromFullName(name);
-                        if (arg.isNotEmpty())
-                            element.setProperty("PDSymbol", nameWithoutArgs + "-" + arg, nullptr);
+                    String formatedArraysText;
+                    for (int i = 0; i < arrays.size(); i++) {
+                        formatedArraysText += arrays[i] + String(i < arrays.size() - 1 ? ", " : "");
                     }
+                    name = "array: " + formatedArraysText;
+                } else if (subpatch->gl_isgraph) {
+                    name = nameWithoutArgs;
+                }
+            } else if (subpatch->gl_isgraph) {
+                name = nameWithoutArgs;
+            }
+#ifdef SHOW_PD_SUBPATCH_SYMBOL
+            if (nameWithoutArgs == "pd") {
+                auto arg = getFirstArgumentFromFullName(name);
+                if (arg.isNotEmpty())
+                    element.setProperty("PDSymbol", nameWithoutArgs + "-" + arg, nullptr);
+            }
 #endif
-                    element.setProperty("Name", name, nullptr);
-                    element.setProperty("RightText", positionText, nullptr);
-                    element.setProperty("Icon", canvas_isabstraction(subpatch->getPointer().get()) ? Icons::File : Icons::Object, nullptr);
-                    element.setProperty("Object", reinterpret_cast<int64>(object.cast<void>()), nullptr);
-                    element.setProperty("TopLevel", reinterpret_cast<int64>(top), nullptr);
-                } else {
-                    String finalFormatedName;
-                    String sendSymbol;
-                    String receiveSymbol;
-
-                    switch (hash(type)) {
-                    // IEM send-receive symbols
-                    case hash("bng"):
-                    case hash("hsl"):
-                    case hash("vsl"):
-                    case hash("slider"):
-                    case hash("tgl"):
-                    case hash("nbx"):
-                    case hash("vradio"):
-                    case hash("hradio"):
-                    case hash("vu"):
-                    case hash("cnv"): {
-                        if (auto iemgui = objectPtr.get<t_iemgui>()) {
-                            t_symbol* srlsym[3];
-                            iemgui_all_sym2dollararg(iemgui.get(), srlsym);
-                            if (srl_is_valid(srlsym[0])) {
-                                sendSymbol = String::fromUTF8(iemgui->x_snd_unexpanded->s_name);
-                            }
-                            if (srl_is_valid(srlsym[1])) {
-                                receiveSymbol = String::fromUTF8(iemgui->x_rcv_unexpanded->s_name);
-                            }
-                        }
-                        finalFormatedName = nameWithoutArgs;
-                        break;
-                    }
-                    case hash("keyboard"): {
-                        if (auto keyboardObject = object.cast<t_fake_keyboard>()) {
-                            sendSymbol = String(keyboardObject->x_send->s_name);
-                            receiveSymbol = String(keyboardObject->x_receive->s_name);
-                        }
-                        finalFormatedName = nameWithoutArgs;
-                        break;
-                    }
-                    case hash("pic"): {
-                        if (auto picObject = object.cast<t_fake_pic>()) {
-                            sendSymbol = String(picObject->x_send->s_name);
-                            receiveSymbol = String(picObject->x_receive->s_name);
-                        }
-                        finalFormatedName = nameWithoutArgs;
-                        break;
-                    }
-                    case hash("scope~"): {
-                        if (auto scopeObject = object.cast<t_fake_scope>()) {
-                            receiveSymbol = String(scopeObject->x_receive->s_name);
-                        }
-                        finalFormatedName = nameWithoutArgs;
-                        break;
-                    }
-                    case hash("function"): {
-                        if (auto keyboardObject = object.cast<t_fake_function>()) {
-                            sendSymbol = String(keyboardObject->x_send->s_name);
-                            receiveSymbol = String(keyboardObject->x_receive->s_name);
-                        }
-                        finalFormatedName = nameWithoutArgs;
-                        break;
-                    }
-                    case hash("note"): {
-                        if (auto noteObject = object.cast<t_fake_note>()) {
-                            receiveSymbol = String(noteObject->x_receive->s_name);
-                        }
-                        finalFormatedName = nameWithoutArgs;
-                        break;
-                    }
-                    case hash("knob"): {
-                        if (auto knobObj = object.cast<t_fake_knob>()) {
-                            sendSymbol = String(knobObj->x_snd->s_name);
-                            receiveSymbol = String(knobObj->x_rcv->s_name);
-                        }
-                        finalFormatedName = nameWithoutArgs;
-                        break;
-                    }
-                    case hash("gatom"): {
-                        auto gatomObject = object.cast<t_fake_gatom>();
-                        String gatomName;
-                        switch (gatomObject->a_flavor) {
-                        case A_FLOAT:
-                            gatomName = "floatbox";
-                            break;
-                        case A_SYMBOL:
-                            gatomName = "symbolbox";
-                            break;
-                        case A_NULL:
-                            gatomName = "listbox";
-                            break;
-                        default:
-                            break;
-                        }
-                        receiveSymbol = String(gatomObject->a_symfrom->s_name);
-                        sendSymbol = String(gatomObject->a_symto->s_name);
-                        finalFormatedName = gatomName;
-                        break;
-                    }
-                    case hash("message"): {
-                        finalFormatedName = "msg: " + name;
-                        break;
-                    }
-                    case hash("comment"): {
-                        finalFormatedName = "comment: " + name;
-                        break;
-                    }
-                    case hash("text"): {
-                        switch (object.cast<t_fake_text_define>()->x_textbuf.b_ob.te_type) {
-                        case T_TEXT: {
-                            // if object & classname is text, then it's a comment
-                            finalFormatedName = String("comment: ") + name;
-                            break;
-                        }
-                        case T_OBJECT: {
-                            // if object is T_OBJECT but classname is 'text' object is in error state
-                            element.setProperty("IconColour", Colours::red.toString(), nullptr);
-
-                            if (name.isEmpty())
-                                finalFormatedName = String("empty");
-                            else
-                                finalFormatedName = String("unknown: ") + name;
-
-                            break;
-                        }
-                        default:
-                            break;
-                        }
-                        break;
+            element.setProperty("Name", name, nullptr);
+            element.setProperty("RightText", positionText, nullptr);
+            element.setProperty("Icon", canvas_isabstraction(subpatch) ? Icons::File : Icons::Object, nullptr);
+            element.setProperty("Object", reinterpret_cast<int64>(gobj), nullptr);
+            element.setProperty("TopLevel", reinterpret_cast<int64>(top), nullptr);
+        } else {
+            String finalFormatedName;
+            String sendSymbol;
+            String receiveSymbol;
+
+            switch (hash(type)) {
+            // IEM send-receive symbols
+            case hash("bng"):
+            case hash("hsl"):
+            case hash("vsl"):
+            case hash("slider"):
+            case hash("tgl"):
+            case hash("nbx"):
+            case hash("vradio"):
+            case hash("hradio"):
+            case hash("vu"):
+            case hash("cnv"): {
+                if (auto* iemgui = reinterpret_cast<t_iemgui*>(gobj)) {
+                    t_symbol* srlsym[3];
+                    iemgui_all_sym2dollararg(iemgui, srlsym);
+                    if (srl_is_valid(srlsym[0])) {
+                        sendSymbol = String::fromUTF8(iemgui->x_snd_unexpanded->s_name);
                     }
-                    case hash("canvas"):
-                    case hash("bicoeff"):
-                    case hash("messbox"):
-                    case hash("pad"):
-                    case hash("button"): {
-                        finalFormatedName = nameWithoutArgs;
-                        break;
+                    if (srl_is_valid(srlsym[1])) {
+                        receiveSymbol = String::fromUTF8(iemgui->x_rcv_unexpanded->s_name);
                     }
+                }
+                finalFormatedName = nameWithoutArgs;
+                break;
+            }
+            case hash("keyboard"): {
+                if (auto* keyboardObject = reinterpret_cast<t_fake_keyboard*>(gobj)) {
+                    sendSymbol = String(keyboardObject->x_send->s_name);
+                    receiveSymbol = String(keyboardObject->x_receive->s_name);
+                }
+                finalFormatedName = nameWithoutArgs;
+                break;
+            }
+            case hash("pic"): {
+                if (auto* picObject = reinterpret_cast<t_fake_pic*>(gobj)) {
+                    sendSymbol = String(picObject->x_send->s_name);
+                    receiveSymbol = String(picObject->x_receive->s_name);
+                }
+                finalFormatedName = nameWithoutArgs;
+                break;
+            }
+            case hash("scope~"): {
+                if (auto* scopeObject = reinterpret_cast<t_fake_scope*>(gobj)) {
+                    receiveSymbol = String(scopeObject->x_receive->s_name);
+                }
+                finalFormatedName = nameWithoutArgs;
+                break;
+            }
+            case hash("function"): {
+                if (auto* keyboardObject = reinterpret_cast<t_fake_function*>(gobj)) {
+                    sendSymbol = String(keyboardObject->x_send->s_name);
+                    receiveSymbol = String(keyboardObject->x_receive->s_name);
+                }
+                finalFormatedName = nameWithoutArgs;
+                break;
+            }
+            case hash("note"): {
+                if (auto* noteObject = reinterpret_cast<t_fake_note*>(gobj)) {
+                    receiveSymbol = String(noteObject->x_receive->s_name);
+                }
+                finalFormatedName = nameWithoutArgs;
+                break;
+            }
+            case hash("knob"): {
+                if (auto* knobObj = reinterpret_cast<t_fake_knob*>(gobj)) {
+                    sendSymbol = String(knobObj->x_snd->s_name);
+                    receiveSymbol = String(knobObj->x_rcv->s_name);
+                }
+                finalFormatedName = nameWithoutArgs;
+                break;
+            }
+            case hash("gatom"): {
+                auto* gatomObject = reinterpret_cast<t_fake_gatom*>(gobj);
+                String gatomName;
+                switch (gatomObject->a_flavor) {
+                case A_FLOAT:
+                    gatomName = "floatbox";
+                    break;
+                case A_SYMBOL:
+                    gatomName = "symbolbox";
+                    break;
+                case A_NULL:
+                    gatomName = "listbox";
+                    break;
+                default:
+                    break;
+                }
+                receiveSymbol = String(gatomObject->a_symfrom->s_name);
+                sendSymbol = String(gatomObject->a_symto->s_name);
+                finalFormatedName = gatomName;
+                break;
+            }
+            case hash("message"): {
+                finalFormatedName = "msg: " + name;
+                break;
+            }
+            case hash("comment"): {
+                finalFormatedName = "comment: " + name;
+                break;
+            }
+            case hash("text"): {
+                switch (reinterpret_cast<t_fake_text_define*>(gobj)->x_textbuf.b_ob.te_type) {
+                case T_TEXT: {
+                    // if object & classname is text, then it's a comment
+                    finalFormatedName = String("comment: ") + name;
+                    break;
+                }
+                case T_OBJECT: {
+                    // if object is T_OBJECT but classname is 'text' object is in error state
+                    element.setProperty("IconColour", Colours::red.toString(), nullptr);
 
-                    default: {
-                        switch (hash(nameWithoutArgs)) {
-                        case hash("s"):
-                        case hash("s~"):
-                        case hash("send"):
-                        case hash("send~"):
-                        case hash("throw~"): {
-                            sendSymbol = getFirstArgumentFromFullName(name);
-                            element.setProperty("SymbolIsObject", 1, nullptr);
-                            finalFormatedName = nameWithoutArgs;
-                            break;
-                        }
-                        case hash("r"):
-                        case hash("r~"):
-                        case hash("receive"):
-                        case hash("receive~"):
-                        case hash("catch~"): {
-                            receiveSymbol = getFirstArgumentFromFullName(name);
-                            element.setProperty("SymbolIsObject", 1, nullptr);
-                            finalFormatedName = nameWithoutArgs;
-                            break;
-                        }
-                        default:
-                            finalFormatedName = name;
-                            break;
-                        }
-                        break;
-                    }
-                    }
+                    if (name.isEmpty())
+                        finalFormatedName = String("empty");
+                    else
+                        finalFormatedName = String("unknown: ") + name;
 
-                    element.setProperty("Name", finalFormatedName, nullptr);
-                    // Add send/receive tags if they exist
-                    if (sendSymbol.isNotEmpty() && (sendSymbol != "empty") && (sendSymbol != "nosndno")) {
-                        element.setProperty("SendSymbol", sendSymbol, nullptr);
-                    }
-                    if (receiveSymbol.isNotEmpty() && (receiveSymbol != "empty")) {
-                        element.setProperty("ReceiveSymbol", receiveSymbol, nullptr);
-                    }
-                    element.setProperty("RightText", positionText, nullptr);
-                    element.setProperty("Icon", Icons::Object, nullptr);
-                    element.setProperty("Object", reinterpret_cast<int64>(object.cast<void>()), nullptr);
-                    element.setProperty("TopLevel", reinterpret_cast<int64>(top), nullptr);
+                    break;
+                }
+                default:
+                    break;
                 }
+                break;
+            }
+            case hash("canvas"):
+            case hash("bicoeff"):
+            case hash("messbox"):
+            case hash("pad"):
+            case hash("button"): {
+                finalFormatedName = nameWithoutArgs;
+                break;
+            }
 
-                patchTree.appendChild(element, nullptr);
+            default: {
+                switch (hash(nameWithoutArgs)) {
+                case hash("s"):
+                case hash("s~"):
+                case hash("send"):
+                case hash("send~"):
+                case hash("throw~"): {
+                    sendSymbol = getFirstArgumentFromFullName(name);
+                    element.setProperty("SymbolIsObject", 1, nullptr);
+                    finalFormatedName = nameWithoutArgs;
+                    break;
+                }
+                case hash("r"):
+                case hash("r~"):
+                case hash("receive"):
+                case hash("receive~"):
+                case hash("catch~"): {
+                    receiveSymbol = getFirstArgumentFromFullName(name);
+                    element.setProperty("SymbolIsObject", 1, nullptr);
+                    finalFormatedName = nameWithoutArgs;
+                    break;
+                }
+                default:
+                    finalFormatedName = name;
+                    break;
+                }
+                break;
+            }
             }
+
+            element.setProperty("Name", finalFormatedName, nullptr);
+            // Add send/receive tags if they exist
+            if (sendSymbol.isNotEmpty() && (sendSymbol != "empty") && (sendSymbol != "nosndno")) {
+                element.setProperty("SendSymbol", sendSymbol, nullptr);
+            }
+            if (receiveSymbol.isNotEmpty() && (receiveSymbol != "empty")) {
+                element.setProperty("ReceiveSymbol", receiveSymbol, nullptr);
+            }
+            element.setProperty("RightText", positionText, nullptr);
+            element.setProperty("Icon", Icons::Object, nullptr);
+            element.setProperty("Object", reinterpret_cast<int64>(gobj), nullptr);
+            element.setProperty("TopLevel", reinterpret_cast<int64>(top), nullptr);
         }
 
-        return patchTree;
+        return element;
     }
 
     SafePointer<Canvas> currentCanvas;
     PluginEditor* editor;
+
+    // The last generated tree for every canvas we've shown, so we only scan patches again after they changed
+    struct PatchTree {
+        SafePointer<Canvas> canvas;
+        ValueTree tree;
+        ElementCache elements;
+    };
+    std::vector<PatchTree> patchTrees;
     ValueTreeViewerComponent patchTree = ValueTreeViewerComponent("(Subpatch)");
     SearchEditor input;
 };
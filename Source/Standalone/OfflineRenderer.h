@@ -0,0 +1,320 @@
+/*
+ // Copyright (c) 2021-2022 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <numeric>
+
+// Renders a patch to an audio file without opening a window or an audio device, as fast as the CPU allows
+// This is meant for regression and load testing on machines without audio hardware:
+//
+// plugdata --render patch.pd --output out.wav [--input in.wav] [--midi in.mid] [--script messages.txt]
+//          [--duration seconds] [--samplerate rate] [--stats timing.csv]
+//
+// The script contains one message per line, prefixed with the time in seconds at which it should be sent: "1.5 synth freq 440"
+class OfflineRenderer {
+public:
+    struct Options {
+        File patch;
+        File output;
+        File input;
+        File midi;
+        File script;
+        File stats;
+        double duration = 0.0;
+        double sampleRate = 0.0;
+    };
+
+    static bool isRenderCommand(String const& arguments)
+    {
+        return StringArray::fromTokens(arguments, true).contains("--render");
+    }
+
+    // Returns the exit code for the application
+    static int render(String const& arguments)
+    {
+        Options options;
+        String error;
+        if (!parseArguments(arguments, options, error)) {
+            std::cerr << error << std::endl
+                      << "Usage: plugdata --render patch.pd --output out.wav [--input in.wav] [--midi in.mid] [--script messages.txt] [--duration seconds] [--samplerate rate] [--stats timing.csv]" << std::endl;
+            return 1;
+        }
+
+        OfflineRenderer renderer(options);
+        return renderer.run();
+    }
+
+private:
+    struct ScriptMessage {
+        int64 samplePosition;
+        String message;
+    };
+
+    explicit OfflineRenderer(Options const& renderOptions)
+        : options(renderOptions)
+    {
+    }
+
+    static bool parseArguments(String const& arguments, Options& options, String& error)
+    {
+        auto args = StringArray::fromTokens(arguments, true);
+        for (auto& arg : args) {
+            arg = arg.unquoted();
+        }
+
+        auto getFile = [](String const& path) {
+            return File::isAbsolutePath(path) ? File(path) : File::getCurrentWorkingDirectory().getChildFile(path);
+        };
+
+        for (int i = 0; i < args.size(); i++) {
+            auto const& arg = args[i];
+            auto const hasValue = i + 1 < args.size();
+
+            if (arg == "--render" && hasValue) {
+                options.patch = getFile(args[++i]);
+            } else if (arg == "--output" && hasValue) {
+                options.output = getFile(args[++i]);
+            } else if (arg == "--input" && hasValue) {
+                options.input = getFile(args[++i]);
+            } else if (arg == "--midi" && hasValue) {
+                options.midi = getFile(args[++i]);
+            } else if (arg == "--script" && hasValue) {
+                options.script = getFile(args[++i]);
+            } else if (arg == "--stats" && hasValue) {
+                options.stats = getFile(args[++i]);
+            } else if (arg == "--duration" && hasValue) {
+                options.duration = args[++i].getDoubleValue();
+            } else if (arg == "--samplerate" && hasValue) {
+                options.sampleRate = args[++i].getDoubleValue();
+            } else {
+                error = "Invalid argument: " + arg;
+                return false;
+            }
+        }
+
+        if (!options.patch.existsAsFile()) {
+            error = "Patch not found: " + options.patch.getFullPathName();
+            return false;
+        }
+        if (options.output == File()) {
+            error = "No output file specified";
+            return false;
+        }
+        for (auto const& file : { options.input, options.midi, options.script }) {
+            if (file != File() && !file.existsAsFile()) {
+                error = "File not found: " + file.getFullPathName();
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    int run()
+    {
+        AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        std::unique_ptr<AudioFormatReader> inputReader;
+        if (options.input.existsAsFile()) {
+            inputReader.reset(formatManager.createReaderFor(options.input));
+            if (!inputReader) {
+                std::cerr << "Can't read audio file: " << options.input.getFullPathName() << std::endl;
+                return 1;
+            }
+        }
+
+        // Without a duration, we render for as long as the input file lasts
+        auto const sampleRate = options.sampleRate > 0.0 ? options.sampleRate : (inputReader ? inputReader->sampleRate : 48000.0);
+        auto const duration = options.duration > 0.0 ? options.duration : (inputReader ? static_cast<double>(inputReader->lengthInSamples) / inputReader->sampleRate : 10.0);
+
+        auto processor = std::make_unique<PluginProcessor>();
+        auto const blockSize = pd::Instance::getBlockSize();
+        auto const numInputs = processor->getTotalNumInputChannels();
+        auto const numOutputs = processor->getTotalNumOutputChannels();
+        auto const numSamples = static_cast<int64>(std::round(duration * sampleRate));
+        auto const numBlocks = static_cast<int>((numSamples + blockSize - 1) / blockSize);
+
+        // We drive performDSP directly, so the oversampler is never used, and pd has to run at the rate we write the file at
+        // Setting the member instead of calling setOversampling makes sure we don't change the user's settings
+        processor->oversampling = 0;
+
+        // Sets up the DSP and turns it on
+        processor->prepareToPlay(sampleRate, blockSize);
+
+        processor->setThis();
+        auto patch = processor->loadPatch(URL(options.patch));
+        if (!patch) {
+            std::cerr << "Can't open patch: " << options.patch.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        options.output.deleteFile();
+        std::unique_ptr<AudioFormatWriter> writer;
+        if (auto* format = formatManager.findFormatForFileExtension(options.output.getFileExtension())) {
+            if (auto outputStream = options.output.createOutputStream()) {
+                writer.reset(format->createWriterFor(outputStream.get(), sampleRate, numOutputs, format->getPossibleBitDepths().getLast(), {}, 0));
+                if (writer)
+                    outputStream.release();
+            }
+        }
+
+        if (!writer) {
+            std::cerr << "Can't write audio file: " << options.output.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        auto const midiEvents = readMidiFile(sampleRate);
+        auto const scriptMessages = readScript(sampleRate);
+        auto nextScriptMessage = scriptMessages.begin();
+
+        std::vector<float> audioVectorIn(numInputs * blockSize, 0.0f);
+        std::vector<float> audioVectorOut(numOutputs * blockSize, 0.0f);
+        AudioBuffer<float> inputBuffer(jmax(1, numInputs), blockSize);
+        AudioBuffer<float> outputBuffer(jmax(1, numOutputs), blockSize);
+        MidiBuffer blockMidi;
+
+        std::vector<double> blockTimes;
+        blockTimes.reserve(numBlocks);
+
+        auto const renderStart = Time::getHighResolutionTicks();
+
+        for (int block = 0; block < numBlocks; block++) {
+            auto const blockStart = static_cast<int64>(block) * blockSize;
+
+            if (inputReader) {
+                inputReader->read(&inputBuffer, 0, blockSize, blockStart, true, true);
+                for (int ch = 0; ch < numInputs; ch++) {
+                    FloatVectorOperations::copy(audioVectorIn.data() + ch * blockSize, inputBuffer.getReadPointer(ch), blockSize);
+                }
+            }
+
+            blockMidi.clear();
+            blockMidi.addEvents(midiEvents, static_cast<int>(blockStart), blockSize, -static_cast<int>(blockStart));
+
+            auto const start = Time::getHighResolutionTicks();
+
+            processor->lockAudioThread();
+            processor->setThis();
+
+            // Messages are only sent at block boundaries, just like when they come from the GUI
+            for (; nextScriptMessage != scriptMessages.end() && nextScriptMessage->samplePosition < blockStart + blockSize; ++nextScriptMessage) {
+                auto const text = nextScriptMessage->message.toStdString();
+                auto* buffer = binbuf_new();
+                binbuf_text(buffer, text.c_str(), text.size());
+                binbuf_eval(buffer, nullptr, 0, nullptr);
+                binbuf_free(buffer);
+            }
+
+            processor->sendMidiBuffer(blockMidi);
+            processor->performDSP(audioVectorIn.data(), audioVectorOut.data());
+            processor->unlockAudioThread();
+
+            blockTimes.push_back(Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1000000.0);
+
+            for (int ch = 0; ch < numOutputs; ch++) {
+                outputBuffer.copyFrom(ch, 0, audioVectorOut.data() + ch * blockSize, blockSize);
+            }
+
+            // The last block can run past the requested duration, only write what's inside it
+            writer->writeFromAudioSampleBuffer(outputBuffer, 0, static_cast<int>(std::min<int64>(blockSize, numSamples - blockStart)));
+        }
+
+        auto const renderTime = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - renderStart);
+
+        writer.reset();
+        processor->patches.removeFirstMatchingValue(patch);
+
+        // Print what the patch printed, so errors in the patch don't go unnoticed
+        for (auto& [object, message, type, length, repeats] : processor->getConsoleMessages()) {
+            (type == 1 ? std::cerr : std::cout) << message << std::endl;
+        }
+
+        printStatistics(blockTimes, renderTime, duration, sampleRate, blockSize);
+        return 0;
+    }
+
+    MidiBuffer readMidiFile(double sampleRate) const
+    {
+        MidiBuffer events;
+        if (!options.midi.existsAsFile())
+            return events;
+
+        FileInputStream stream(options.midi);
+        MidiFile midiFile;
+        if (!stream.openedOk() || !midiFile.readFrom(stream)) {
+            std::cerr << "Can't read MIDI file: " << options.midi.getFullPathName() << std::endl;
+            return events;
+        }
+
+        midiFile.convertTimestampTicksToSeconds();
+        for (int track = 0; track < midiFile.getNumTracks(); track++) {
+            for (auto const* event : *midiFile.getTrack(track)) {
+                if (!event->message.isMetaEvent()) {
+                    events.addEvent(event->message, roundToInt(event->message.getTimeStamp() * sampleRate));
+                }
+            }
+        }
+
+        return events;
+    }
+
+    std::vector<ScriptMessage> readScript(double sampleRate) const
+    {
+        std::vector<ScriptMessage> messages;
+        if (!options.script.existsAsFile())
+            return messages;
+
+        StringArray lines;
+        options.script.readLines(lines);
+        for (auto const& line : lines) {
+            auto const trimmed = line.trim();
+            if (trimmed.isEmpty() || trimmed.startsWithChar('#'))
+                continue;
+
+            auto const time = trimmed.upToFirstOccurrenceOf(" ", false, false).getDoubleValue();
+            auto const message = trimmed.fromFirstOccurrenceOf(" ", false, false).trim();
+            messages.push_back({ static_cast<int64>(time * sampleRate), message });
+        }
+
+        std::stable_sort(messages.begin(), messages.end(), [](auto const& a, auto const& b) {
+            return a.samplePosition < b.samplePosition;
+        });
+
+        return messages;
+    }
+
+    void printStatistics(std::vector<double> blockTimes, double renderTime, double duration, double sampleRate, int blockSize) const
+    {
+        if (options.stats != File()) {
+            String csv = "block,microseconds\n";
+            for (size_t i = 0; i < blockTimes.size(); i++) {
+                csv += String(static_cast<int64>(i)) + "," + String(blockTimes[i], 3) + "\n";
+            }
+            options.stats.replaceWithText(csv);
+        }
+
+        if (blockTimes.empty())
+            return;
+
+        auto const total = std::accumulate(blockTimes.begin(), blockTimes.end(), 0.0);
+        std::sort(blockTimes.begin(), blockTimes.end());
+        auto percentile = [&blockTimes](double fraction) {
+            return blockTimes[std::min(blockTimes.size() - 1, static_cast<size_t>(fraction * static_cast<double>(blockTimes.size())))];
+        };
+
+        auto const budget = blockSize / sampleRate * 1000000.0;
+        std::cout << "Rendered " << duration << "s of audio in " << renderTime << "s (" << duration / renderTime << "x realtime)" << std::endl
+                  << "Time per block of " << blockSize << " samples, budget " << budget << "us:" << std::endl
+                  << "  average " << total / static_cast<double>(blockTimes.size()) << "us" << std::endl
+                  << "  median  " << percentile(0.5) << "us" << std::endl
+                  << "  p99     " << percentile(0.99) << "us" << std::endl
+                  << "  max     " << blockTimes.back() << "us" << std::endl;
+    }
+
+    Options options;
+};
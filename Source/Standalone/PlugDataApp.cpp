@@ -30,6 +30,7 @@
 #include "PluginEditor.h"
 
 #include "Dialogs/Dialogs.h"
+#include "OfflineRenderer.h"
 
 #if JUCE_WINDOWS
 #    include <filesystem>
@@ -107,6 +108,13 @@ public:
 
     void initialise(String const& arguments) override
     {
+        // Headless mode: render a patch to a file and quit, without creating a window or opening an audio device
+        if (OfflineRenderer::isRenderCommand(arguments)) {
+            setApplicationReturnValue(OfflineRenderer::render(arguments));
+            quit();
+            return;
+        }
+
         LookAndFeel::getDefaultLookAndFeel().setColour(ResizableWindow::backgroundColourId, Colours::transparentBlack);
 
         pluginHolder = std::make_unique<StandalonePluginHolder>(appProperties.getUserSettings(), false, "");
@@ -149,7 +157,8 @@ public:
     void shutdown() override
     {
         mainWindow = nullptr;
-        pluginHolder->stopPlaying();
+        if (pluginHolder)
+            pluginHolder->stopPlaying();
         pluginHolder = nullptr;
         appProperties.saveIfNeeded();
     }
@@ -246,7 +255,7 @@ public:
 
 protected:
     ApplicationProperties appProperties;
-    PlugDataWindow* mainWindow;
+    PlugDataWindow* mainWindow = nullptr;
 };
 
 void PlugDataWindow::closeAllPatches()
@@ -442,9 +442,11 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CPUHistoryGraph);
 };
 
-class CPUMeterPopup : public Component {
+class CPUMeterPopup : public Component
+    , public ChangeListener {
 public:
-    CPUMeterPopup(CircularBuffer<float>& history, CircularBuffer<float>& longHistory)
+    CPUMeterPopup(CircularBuffer<float>& history, CircularBuffer<float>& longHistory, pd::DSPProfiler& dspProfiler)
+        : profiler(dspProfiler)
     {
         cpuGraph = std::make_unique<CPUHistoryGraph>(history, 200);
         cpuGraphLongHistory = std::make_unique<CPUHistoryGraph>(longHistory, 300);
@@ -461,6 +463,11 @@ public:
         slowGraphTitle.setJustificationType(Justification::centred);
         addAndMakeVisible(slowGraphTitle);
 
+        patchLoadTitle.setText("DSP load per patch", dontSendNotification);
+        patchLoadTitle.setFont(Fonts::getBoldFont().withHeight(14.0f));
+        patchLoadTitle.setJustificationType(Justification::centred);
+        addAndMakeVisible(patchLoadTitle);
+
         linear.setConnectedEdges(TextButton::ConnectedEdgeFlags::ConnectedOnRight);
         logA.setConnectedEdges(TextButton::ConnectedEdgeFlags::ConnectedOnLeft | TextButton::ConnectedEdgeFlags::ConnectedOnRight);
         logB.setConnectedEdges(TextButton::ConnectedEdgeFlags::ConnectedOnLeft);
@@ -489,14 +496,48 @@ public:
         auto currentMappingMode = SettingsFile::getInstance()->getPropertyAsValue("cpu_meter_mapping_mode").getValue();
         buttons[currentMappingMode]->setToggleState(true, dontSendNotification);
 
-        setSize(212, 177);
+        // The profiler only measures while something is showing its results
+        // We only need the total per patch, which doesn't add overhead to every object like the object profiler does
+        profiler.addUser(pd::DSPProfiler::Mode::Patches);
+        profiler.addChangeListener(this);
+
+        setSize(212, 203 + maxPatchRows * patchRowHeight);
     }
 
     ~CPUMeterPopup() override
     {
+        profiler.removeChangeListener(this);
+        profiler.removeUser(pd::DSPProfiler::Mode::Patches);
         onClose();
     }
 
+    void changeListenerCallback(ChangeBroadcaster* source) override
+    {
+        patchRows = profiler.getPatchStatistics();
+
+        // While the object profiler is open, the per-patch figures include the overhead of timing every object
+        patchLoadTitle.setText(profiler.isMeasuringObjects() ? "DSP load per patch (instrumented)" : "DSP load per patch", dontSendNotification);
+        repaint();
+    }
+
+    void paint(Graphics& g) override
+    {
+        auto textColour = findColour(PlugDataColour::popupMenuTextColourId);
+        auto bounds = getLocalBounds().withTop(patchLoadTitle.getBottom()).reduced(8, 0);
+
+        if (patchRows.empty()) {
+            Fonts::drawText(g, "No DSP measured yet", bounds.removeFromTop(patchRowHeight), textColour.withAlpha(0.5f), 13, Justification::centred);
+            return;
+        }
+
+        for (int i = 0; i < std::min<int>(maxPatchRows, patchRows.size()); i++) {
+            auto row = bounds.removeFromTop(patchRowHeight);
+            auto const& patch = patchRows[i];
+            Fonts::drawText(g, String(patch.load * 100.0f, 1) + "%", row.removeFromRight(48), textColour, 13, Justification::centredRight);
+            Fonts::drawText(g, patch.name, row, textColour, 13);
+        }
+    }
+
     void resized() override
     {
         fastGraphTitle.setBounds(0, 6, getWidth(), 20);
@@ -509,6 +550,8 @@ public:
         linear.setBounds(b.removeFromLeft(buttonWidth));
         logA.setBounds(b.removeFromLeft(buttonWidth).expanded(1, 0));
         logB.setBounds(b.removeFromLeft(buttonWidth).expanded(1, 0));
+
+        patchLoadTitle.setBounds(0, linear.getBottom() + 6, getWidth(), 20);
     }
 
     std::function<void()> getUpdateFunc()
@@ -540,6 +583,7 @@ private:
 
     Label fastGraphTitle;
     Label slowGraphTitle;
+    Label patchLoadTitle;
     std::unique_ptr<CPUHistoryGraph> cpuGraph;
     std::unique_ptr<CPUHistoryGraph> cpuGraphLongHistory;
 
@@ -547,6 +591,12 @@ private:
     TextButton logA = TextButton("Log A");
     TextButton logB = TextButton("Log B");
 
+    // Share of the measured DSP time for every open patch, so it's clear which patch is keeping the audio thread busy
+    pd::DSPProfiler& profiler;
+    std::vector<pd::DSPProfiler::PatchStatistics> patchRows;
+    static constexpr int maxPatchRows = 5;
+    static constexpr int patchRowHeight = 18;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CPUMeterPopup);
 };
 
@@ -600,7 +650,8 @@ public:
     void mouseUp(MouseEvent const& e) override
     {
         if (!isCallOutBoxActive) {
-            auto cpuHistory = std::make_unique<CPUMeterPopup>(cpuUsage, cpuUsageLongHistory);
+            auto* editor = findParentComponentOfClass<PluginEditor>();
+            auto cpuHistory = std::make_unique<CPUMeterPopup>(cpuUsage, cpuUsageLongHistory, *editor->pd->dspProfiler);
             updateCPUGraph = cpuHistory->getUpdateFunc();
             updateCPUGraphLong = cpuHistory->getUpdateFuncLongHistory();
 
@@ -610,7 +661,6 @@ public:
                 repaint();
             };
 
-            auto* editor = findParentComponentOfClass<PluginEditor>();
             currentCalloutBox = &editor->showCalloutBox(std::move(cpuHistory), getScreenBounds());
             isCallOutBoxActive = true;
         } else {
@@ -1055,6 +1105,10 @@ void StatusbarSource::timerCallback()
             listener->audioProcessedChanged(hasProcessedAudio);
     }
 
+    if (auto const numDropped = numDroppedMidiEvents.exchange(0, std::memory_order_relaxed)) {
+        onMidiEventsDropped(numDropped);
+    }
+
     auto peak = peakBuffer.getPeak();
 
     for (auto* listener : listeners) {
@@ -1077,3 +1131,8 @@ void StatusbarSource::setCPUUsage(float cpu)
 {
     cpuUsage.store(cpu, std::memory_order_relaxed);
 }
+
+void StatusbarSource::addDroppedMidiEvents(int numDropped)
+{
+    numDroppedMidiEvents.fetch_add(numDropped, std::memory_order_relaxed);
+}
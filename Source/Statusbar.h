@@ -50,6 +50,10 @@ public:
 
     void setCPUUsage(float cpuUsage);
 
+    // Called from the audio thread when MIDI events had to be dropped, they're reported from the message thread
+    void addDroppedMidiEvents(int numDropped);
+    std::function<void(int)> onMidiEventsDropped = [](int) {};
+
     AudioSampleRingBuffer peakBuffer;
 
 private:
@@ -57,6 +61,7 @@ private:
     std::atomic<int> lastMidiSentTime = 0;
     std::atomic<int> lastAudioProcessedTime = 0;
     std::atomic<float> cpuUsage;
+    std::atomic<int> numDroppedMidiEvents = 0;
 
     int numChannels;
     int bufferSize;
@@ -19,6 +19,8 @@ public:
     {
         fifo.setTotalSize(maxSize + 1);
         audioBuffer.setSize(channels, maxSize + 1);
+        midiData.resize(midiFifoSize);
+        midiEventData.resize(midiFifoSize);
 
         clear();
     }
@@ -27,7 +29,12 @@ public:
     {
         fifo.reset();
         audioBuffer.clear();
-        midiBuffer.clear();
+
+        midiReadIndex = 0;
+        midiWriteIndex = 0;
+        numSamplesWritten = 0;
+        numSamplesRead = 0;
+        numDroppedMidiEvents = 0;
     }
 
     int getNumSamplesAvailable() { return fifo.getNumReady(); }
@@ -38,7 +45,7 @@ public:
         jassert(getNumSamplesFree() >= audioSrc.getNumSamples());
         jassert(audioSrc.getNumChannels() == audioBuffer.getNumChannels());
 
-        midiBuffer.addEvents(midiSrc, 0, audioSrc.getNumSamples(), fifo.getNumReady());
+        writeMidi(midiSrc, audioSrc.getNumSamples());
 
         int start1, size1, start2, size2;
         fifo.prepareToWrite(audioSrc.getNumSamples(), start1, size1, start2, size2);
@@ -56,12 +63,7 @@ public:
         jassert(getNumSamplesAvailable() >= audioDst.getNumSamples());
         jassert(audioDst.getNumChannels() == audioBuffer.getNumChannels());
 
-        midiDst.addEvents(midiBuffer, 0, audioDst.getNumSamples(), 0);
-
-        // Move all the remaining midi events forward by the number of samples removed
-        MidiBuffer temp;
-        temp.addEvents(midiBuffer, audioDst.getNumSamples(), fifo.getNumReady(), -audioDst.getNumSamples());
-        midiBuffer = temp;
+        readMidi(midiDst, audioDst.getNumSamples());
 
         int start1, size1, start2, size2;
         fifo.prepareToRead(audioDst.getNumSamples(), start1, size1, start2, size2);
@@ -87,6 +89,7 @@ public:
             audioBuffer.clear(start2, size2);
 
         fifo.finishedWrite(size1 + size2);
+        numSamplesWritten += numSamples;
     }
 
     void writeAudioAndMidi(juce::AudioBuffer<float> const& audioSrc, juce::MidiBuffer const& midiSrc)
@@ -94,7 +97,7 @@ public:
         jassert(getNumSamplesFree() >= audioSrc.getNumSamples());
         jassert(audioSrc.getNumChannels() == audioBuffer.getNumChannels());
 
-        midiBuffer.addEvents(midiSrc, 0, audioSrc.getNumSamples(), fifo.getNumReady());
+        writeMidi(midiSrc, audioSrc.getNumSamples());
 
         int start1, size1, start2, size2;
         fifo.prepareToWrite(audioSrc.getNumSamples(), start1, size1, start2, size2);
@@ -115,12 +118,7 @@ public:
         jassert(getNumSamplesAvailable() >= audioDst.getNumSamples());
         jassert(audioDst.getNumChannels() == audioBuffer.getNumChannels());
 
-        midiDst.addEvents(midiBuffer, 0, audioDst.getNumSamples(), 0);
-
-        // Move all the remaining midi events forward by the number of samples removed
-        juce::MidiBuffer temp;
-        temp.addEvents(midiBuffer, audioDst.getNumSamples(), fifo.getNumReady(), -audioDst.getNumSamples());
-        midiBuffer = temp;
+        readMidi(midiDst, audioDst.getNumSamples());
 
         int start1, size1, start2, size2;
         fifo.prepareToRead(audioDst.getNumSamples(), start1, size1, start2, size2);
@@ -136,10 +134,103 @@ public:
         fifo.finishedRead(size1 + size2);
     }
 
+    // Returns how many MIDI events didn't fit in the fifo since the last call, so the caller can warn about it outside of the fifo
+    int getAndResetNumDroppedMidiEvents()
+    {
+        return std::exchange(numDroppedMidiEvents, 0);
+    }
+
 private:
+    // MIDI events are stored in a preallocated ring of bytes, as [timestamp][size][data] records
+    // Timestamps are absolute sample positions, so reading only needs to subtract the read position instead of shifting all remaining events
+    struct MidiEventHeader {
+        int64 timestamp;
+        int size;
+    };
+
+    void writeMidi(MidiBuffer const& midiSrc, int numSamples)
+    {
+        for (auto const event : midiSrc) {
+            if (!isPositiveAndBelow(event.samplePosition, numSamples))
+                continue;
+
+            // Events of any size are kept, as long as they fit in the fifo, so large sysex dumps also get through
+            auto const recordSize = sizeof(MidiEventHeader) + static_cast<size_t>(event.numBytes);
+            if (recordSize > midiFifoSize - (midiWriteIndex - midiReadIndex)) {
+                jassertfalse; // MIDI fifo is full, event will be dropped
+                numDroppedMidiEvents++;
+                continue;
+            }
+
+            MidiEventHeader header { numSamplesWritten + event.samplePosition, event.numBytes };
+            writeMidiBytes(&header, sizeof(MidiEventHeader));
+            writeMidiBytes(event.data, static_cast<size_t>(event.numBytes));
+        }
+
+        numSamplesWritten += numSamples;
+    }
+
+    void readMidi(MidiBuffer& midiDst, int numSamples)
+    {
+        auto const endTime = numSamplesRead + numSamples;
+
+        while (midiReadIndex != midiWriteIndex) {
+            MidiEventHeader header;
+            peekMidiBytes(&header, sizeof(MidiEventHeader), midiReadIndex);
+
+            if (header.timestamp >= endTime)
+                break;
+
+            midiReadIndex += sizeof(MidiEventHeader);
+
+            // Events that wrap around the end of the ring are copied out first, the rest can be added straight from the ring
+            auto const start = midiReadIndex % midiFifoSize;
+            auto const samplePosition = static_cast<int>(jmax<int64>(0, header.timestamp - numSamplesRead));
+            if (start + static_cast<size_t>(header.size) <= midiFifoSize) {
+                midiDst.addEvent(midiData.data() + start, header.size, samplePosition);
+            } else {
+                peekMidiBytes(midiEventData.data(), static_cast<size_t>(header.size), midiReadIndex);
+                midiDst.addEvent(midiEventData.data(), header.size, samplePosition);
+            }
+
+            midiReadIndex += static_cast<size_t>(header.size);
+        }
+
+        numSamplesRead = endTime;
+    }
+
+    void writeMidiBytes(void const* src, size_t numBytes)
+    {
+        auto const start = midiWriteIndex % midiFifoSize;
+        auto const size1 = std::min(numBytes, midiFifoSize - start);
+
+        std::memcpy(midiData.data() + start, src, size1);
+        std::memcpy(midiData.data(), static_cast<uint8 const*>(src) + size1, numBytes - size1);
+
+        midiWriteIndex += numBytes;
+    }
+
+    void peekMidiBytes(void* dst, size_t numBytes, size_t readIndex) const
+    {
+        auto const start = readIndex % midiFifoSize;
+        auto const size1 = std::min(numBytes, midiFifoSize - start);
+
+        std::memcpy(dst, midiData.data() + start, size1);
+        std::memcpy(static_cast<uint8*>(dst) + size1, midiData.data(), numBytes - size1);
+    }
+
+    static constexpr size_t midiFifoSize = 1 << 16;
+
     AbstractFifo fifo { 1 };
     AudioBuffer<float> audioBuffer;
-    MidiBuffer midiBuffer;
+
+    std::vector<uint8> midiData;
+    std::vector<uint8> midiEventData; // For events that wrap around the end of the ring
+    size_t midiReadIndex = 0;
+    size_t midiWriteIndex = 0;
+    int64 numSamplesWritten = 0;
+    int64 numSamplesRead = 0;
+    int numDroppedMidiEvents = 0;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioMidiFifo)
 };
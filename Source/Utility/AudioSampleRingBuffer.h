@@ -4,6 +4,11 @@
 #include <atomic>
 
 /*
+    Single producer/single consumer peak meter buffer
+
+    The audio thread splits incoming blocks into chunks, and stores the peak of every chunk in a ring
+    The GUI thread estimates where the audio thread is right now, and takes the maximum over the chunks in the peak window
+
                     read                        write
                     (oldwrite pos - window size │
                     │                           │
@@ -21,86 +26,91 @@ public:
     {
     }
 
-    void reset(double sourceSampleRate, int sourceBufferSize, int numChannels)
+    // Called from prepareToPlay, while the audio thread is not writing
+    void reset(double sourceSampleRate, int sourceBufferSize, int channels)
     {
-        ScopedLock lock(audioBufferMutex);
-        
+        ScopedLock lock(resetLock);
+
         sampleRate = sourceSampleRate;
         mainBufferSize = sourceBufferSize;
         peakWindowSize = sampleRate / 60;
         bufferSize = jmax(peakWindowSize, mainBufferSize) * 3;
+        chunkSize = jmax(1, peakWindowSize / 16);
+        numChunks = bufferSize / chunkSize + 1;
+        numChannels = channels;
+
+        chunkPeaks = std::make_unique<std::atomic<float>[]>(static_cast<size_t>(numChunks * numChannels));
+        for (int i = 0; i < numChunks * numChannels; i++) {
+            chunkPeaks[i].store(0.0f, std::memory_order_relaxed);
+        }
 
-        peakBuffer.setSize(numChannels, peakWindowSize, true, true);
-        buffer.setSize(numChannels, bufferSize, false, true);
-        useNewPosition = true;
+        lastBlockStart.store(0, std::memory_order_relaxed);
+        samplesWritten.store(0, std::memory_order_release);
     }
 
     void write(AudioBuffer<float>& samples)
     {
-        ScopedLock lock(audioBufferMutex);
-        
-        for (int ch = 0; ch < peakBuffer.getNumChannels(); ch++) {
-            for (int i = 0; i < samples.getNumSamples(); i++) {
-                buffer.setSample(ch, (writePosition + i) % buffer.getNumSamples(), samples.getSample(ch, i));
+        if (!chunkPeaks)
+            return;
+
+        auto const numSamples = samples.getNumSamples();
+        auto const numChannelsToWrite = jmin(samples.getNumChannels(), numChannels);
+        auto const blockStart = samplesWritten.load(std::memory_order_relaxed);
+        auto position = blockStart;
+
+        int offset = 0;
+        while (offset < numSamples) {
+            auto const chunkOffset = static_cast<int>(position % chunkSize);
+            auto const length = jmin(chunkSize - chunkOffset, numSamples - offset);
+            auto* chunk = chunkPeaks.get() + ((position / chunkSize) % numChunks) * numChannels;
+
+            for (int ch = 0; ch < numChannelsToWrite; ch++) {
+                auto const range = FloatVectorOperations::findMinAndMax(samples.getReadPointer(ch, offset), length);
+                auto const peak = jmax(-range.getStart(), range.getEnd());
+
+                // Continue the chunk that the previous block left unfinished
+                if (chunkOffset != 0)
+                    chunk[ch].store(jmax(chunk[ch].load(std::memory_order_relaxed), peak), std::memory_order_relaxed);
+                else
+                    chunk[ch].store(peak, std::memory_order_relaxed);
             }
+
+            offset += length;
+            position += length;
         }
 
-        writeTime = Time::getMillisecondCounter();
-        oldWritePosition = writePosition;
-        writePosition = (writePosition + samples.getNumSamples()) % buffer.getNumSamples();
-        useNewPosition = true;
+        lastWriteTime.store(Time::getMillisecondCounter(), std::memory_order_relaxed);
+        lastBlockStart.store(blockStart, std::memory_order_relaxed);
+        samplesWritten.store(position, std::memory_order_release);
     }
 
     Array<float> getPeak()
     {
-        ScopedLock lock(audioBufferMutex);
-        
-        if (sampleRate == 0)
-            return { 0.0f, 0.0f };
-        auto currentTime = Time::getMillisecondCounter();
-
-        if (useNewPosition) {
-            readTime = writeTime;
-            readPosition = oldWritePosition;
-            useNewPosition = false;
-        }
+        ScopedLock lock(resetLock);
 
-        auto diff = currentTime - readTime;
-
-        int readPos = readPosition + std::ceil((diff / 1000) * sampleRate) - mainBufferSize - peakWindowSize;
-
-        while (readPos < 0)
-            readPos += bufferSize;
-
-        while (readPos >= buffer.getNumSamples())
-            readPos -= bufferSize;
+        if (sampleRate == 0 || !chunkPeaks)
+            return { 0.0f, 0.0f };
 
-        for (int ch = 0; ch < std::min(2, peakBuffer.getNumChannels()); ch++) {
-            // Get pointers to the source and destination data
-            auto const* srcData = buffer.getReadPointer(ch);
-            auto* destData = peakBuffer.getWritePointer(ch);
+        auto const written = samplesWritten.load(std::memory_order_acquire);
+        auto const blockStart = lastBlockStart.load(std::memory_order_relaxed);
+        auto const diff = static_cast<double>(Time::getMillisecondCounter() - lastWriteTime.load(std::memory_order_relaxed));
 
-            int readPosWrapped = (readPos + peakWindowSize) % bufferSize;
-            if (readPosWrapped < peakWindowSize) {
-                // Calculate the length of the first copy operation
-                int firstCopyLength = bufferSize - readPos;
+        // Estimate how far the audio callback has progressed since the last block was written
+        auto readEnd = jmin<int64>(written, blockStart + static_cast<int64>(std::ceil((diff / 1000.0) * sampleRate)) - mainBufferSize);
+        auto readStart = readEnd - peakWindowSize;
 
-                // Perform the first copy operation
-                juce::FloatVectorOperations::copy(destData, srcData + readPos, firstCopyLength);
+        // Don't read chunks that the audio thread might already be overwriting
+        readStart = jmax<int64>(readStart, written - static_cast<int64>(numChunks - 2) * chunkSize, 0);
 
-                // Perform the second copy operation
-                juce::FloatVectorOperations::copy(destData + firstCopyLength, srcData, peakWindowSize - firstCopyLength);
-            } else {
-                // If no wrap-around is needed, perform a single SIMD copy operation
-                juce::FloatVectorOperations::copy(destData, srcData + readPos, peakWindowSize);
+        Array<float> peak;
+        for (int ch = 0; ch < numChannels; ch++) {
+            float magnitude = 0.0f;
+            for (auto chunk = readStart / chunkSize; chunk * chunkSize < readEnd; chunk++) {
+                magnitude = jmax(magnitude, chunkPeaks[(chunk % numChunks) * numChannels + ch].load(std::memory_order_relaxed));
             }
+            peak.add(pow(magnitude, 0.5f));
         }
 
-        Array<float> peak;
-        for (int ch = 0; ch < peakBuffer.getNumChannels(); ch++) {
-            peak.add(pow(peakBuffer.getMagnitude(ch, 0, peakWindowSize), 0.5f));
-        }
-        
         return peak;
     }
 
@@ -109,15 +119,16 @@ private:
     int mainBufferSize = 0;
     int sampleRate = 0;
     int peakWindowSize = 0;
+    int chunkSize = 1;
+    int numChunks = 0;
+    int numChannels = 0;
+
+    std::unique_ptr<std::atomic<float>[]> chunkPeaks;
 
-    AudioBuffer<float> buffer;
-    AudioBuffer<float> peakBuffer;
+    std::atomic<int64> samplesWritten = 0;
+    std::atomic<int64> lastBlockStart = 0;
+    std::atomic<uint32> lastWriteTime = 0;
 
-    int writePosition = 0;
-    int oldWritePosition = 0;
-    int readPosition = 0;
-    bool useNewPosition = false;
-    double writeTime = 0;
-    double readTime = 0;
-    CriticalSection audioBufferMutex;
+    // Only protects reallocation against the GUI reading, the audio thread never takes this lock
+    CriticalSection resetLock;
 };
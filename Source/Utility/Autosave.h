@@ -1,32 +1,41 @@
 #pragma once
-#include <readerwriterqueue.h>
 #include "Dialogs/Dialogs.h"
 #include "Components/BouncingViewport.h"
 
+// Autosaves are stored in an append-only journal: every record holds either the full content of a patch, or only the part that changed since the previous record for that patch
+// Records are compressed, and when the journal grows too large, it's compacted by rewriting it with a single full record per patch
 class Autosave : public Timer
-    , public AsyncUpdater
     , public Value::Listener {
 
-    static inline File const autoSaveFile = ProjectInfo::appDataDir.getChildFile(".autosave");
+    static inline File const autoSaveFile = ProjectInfo::appDataDir.getChildFile(".autosave_journal");
+    static inline File const legacyAutoSaveFile = ProjectInfo::appDataDir.getChildFile(".autosave");
     static inline ValueTree autoSaveTree = ValueTree("Autosave");
+    static inline int numJournalRecords = 0;
+
+    static constexpr int journalMagic = 0x706a726e;
+    static constexpr int journalVersion = 1;
+    static constexpr int maxAutosavedPatches = 15;
+    static constexpr int maxJournalRecords = 256;
+    static constexpr int64 maxJournalSize = 4 * 1024 * 1024;
+
+    enum RecordType {
+        FullRecord = 0,
+        DeltaRecord
+    };
+
     Value autosaveInterval;
     Value autosaveEnabled;
 
     PluginProcessor* pd;
-    moodycamel::ReaderWriterQueue<std::pair<String, String>> autoSaveQueue;
 
 public:
     Autosave(PluginProcessor* procesor)
         : pd(procesor)
     {
-        if (!autoSaveFile.existsAsFile()) {
-            autoSaveFile.create();
-        } else {
-            FileInputStream istream(autoSaveFile);
-            autoSaveTree = ValueTree::readFromStream(istream);
-            // In case something went wrong
-            if (!autoSaveTree.isValid())
-                autoSaveTree = ValueTree("Autosave");
+        if (autoSaveFile.existsAsFile()) {
+            readJournal();
+        } else if (legacyAutoSaveFile.existsAsFile()) {
+            importLegacyAutosave();
         }
 
         autosaveEnabled.referTo(SettingsFile::getInstance()->getPropertyAsValue("autosave_enabled"));
@@ -49,9 +58,7 @@ public:
             Dialogs::showOkayCancelDialog(
                 &editor->openedDialog, editor, "Restore autosave?\n (last autosave is " + timeDescription + " newer)", [lastAutoSavedPatch, patchPath, callback](bool useAutosaved) {
                     if (useAutosaved) {
-                        MemoryOutputStream ostream;
-                        Base64::convertFromBase64(ostream, lastAutoSavedPatch.getProperty("Patch").toString());
-                        auto autosavedPatch = String::fromUTF8((const char*)ostream.getData(), ostream.getDataSize());
+                        auto autosavedPatch = lastAutoSavedPatch.getProperty("Patch").toString();
                         patchPath.replaceWithText(autosavedPatch);
                         // TODO: instead of replacing, it would be better to load it as a string, (but also with the correct patch path)
                     }
@@ -78,37 +85,44 @@ private:
         if (!getValue<bool>(autosaveEnabled))
             return;
 
-        pd->enqueueFunctionAsync([_this = WeakReference(this)]() {
-            if (_this)
-                _this->save();
-        });
+        save();
     }
 
+    // Runs on the message thread: the audio thread is only locked while checking if a patch is dirty, and by the content snapshot if the patch changed
     void save()
     {
-        ScopedTryLock const stl(pd->patches.getLock());
-        if (stl.isLocked()) {
-            for (auto& patch : pd->patches) {
-                auto* patchPtr = patch->getPointer().get();
-                if (!patchPtr || !patchPtr->gl_dirty)
-                    continue;
+        pd->setThis();
 
-                // Check if patch is a root canvas
-                for (auto* x = pd_getcanvaslist(); x; x = x->gl_next) {
-                    if (x == patchPtr) {
-
-                        auto patchFile = patch->getPatchFile();
-
-                        // Simple way to filter out plugdata default patches which we don't want to save.
-                        if (!isInternalPatch(patchFile)) {
-                            autoSaveQueue.enqueue({ patchFile.getFullPathName(), patch->getCanvasContent() });
-                        }
+        int64 time = 0;
+        auto const patches = pd->patches;
+        for (auto& patch : patches) {
+            bool isDirtyRootCanvas = false;
 
-                        triggerAsyncUpdate();
+            pd->lockAudioThread();
+            if (auto patchPtr = patch->getPointer()) {
+                // Check if patch is a root canvas
+                for (auto* x = pd_getcanvaslist(); x && patchPtr->gl_dirty; x = x->gl_next) {
+                    if (x == patchPtr.get()) {
+                        isDirtyRootCanvas = true;
                         break;
                     }
                 }
             }
+            pd->unlockAudioThread();
+
+            if (!isDirtyRootCanvas)
+                continue;
+
+            auto patchFile = patch->getPatchFile();
+
+            // Simple way to filter out plugdata default patches which we don't want to save.
+            if (isInternalPatch(patchFile))
+                continue;
+
+            if (!time)
+                time = getFileSystemTime();
+
+            appendToJournal(patchFile.getFullPathName(), patch->getContentSnapshot(), time);
         }
     }
 
@@ -118,52 +132,218 @@ private:
         return pathName.contains("Documents/plugdata/Abstractions") || pathName.contains("Documents/plugdata/Documentation") || pathName.contains("Documents/plugdata/Extra") || patch.getParentDirectory() == File::getSpecialLocation(File::tempDirectory);
     }
 
-    void handleAsyncUpdate() override
+    static int64 getFileSystemTime()
     {
-        std::pair<String, String> pathAndContent;
-        while (autoSaveQueue.try_dequeue(pathAndContent)) {
-            auto& [path, content] = pathAndContent;
-
-            // Make sure we get current time in the correct format used by the OS for file modification time
-            auto tempFile = File::createTempFile("temp_time_test");
-            tempFile.create();
-            auto time = tempFile.getCreationTime().toMilliseconds();
-            tempFile.deleteFile();
-
-            auto existingPatch = autoSaveTree.getChildWithProperty("Path", path);
-
-            if (existingPatch.isValid()) {
-                existingPatch.setProperty("Patch", Base64::toBase64(content), nullptr);
-                existingPatch.setProperty("LastModified", (int64)time, nullptr);
-            } else {
-                ValueTree newAutoSave = ValueTree("Save");
-                newAutoSave.setProperty("Path", path, nullptr);
-                newAutoSave.setProperty("Patch", Base64::toBase64(content), nullptr);
-                newAutoSave.setProperty("LastModified", (int64)time, nullptr);
-                autoSaveTree.addChild(newAutoSave, 0, nullptr);
-
-                if (autoSaveTree.getNumChildren() > 15) {
-                    int64 oldestTime = std::numeric_limits<int64>::max();
-                    int oldestIdx = -1;
-                    int currentIdx = 0;
-                    for (auto autoSave : autoSaveTree) {
-                        auto modifiedTime = static_cast<int64>(autoSave.getProperty("LastModified"));
-                        if (modifiedTime < oldestTime) {
-                            oldestTime = modifiedTime;
-                            oldestIdx = currentIdx;
-                        }
-                        currentIdx++;
-                    }
-                    if (oldestIdx >= 0) {
-                        autoSaveTree.removeChild(oldestIdx, nullptr);
-                    }
+        // Make sure we get current time in the correct format used by the OS for file modification time
+        auto tempFile = File::createTempFile("temp_time_test");
+        tempFile.create();
+        auto time = tempFile.getCreationTime().toMilliseconds();
+        tempFile.deleteFile();
+        return time;
+    }
+
+    static void setAutosavedPatch(String const& path, String const& content, int64 time)
+    {
+        auto existingPatch = autoSaveTree.getChildWithProperty("Path", path);
+
+        if (existingPatch.isValid()) {
+            existingPatch.setProperty("Patch", content, nullptr);
+            existingPatch.setProperty("LastModified", time, nullptr);
+            return;
+        }
+
+        ValueTree newAutoSave = ValueTree("Save");
+        newAutoSave.setProperty("Path", path, nullptr);
+        newAutoSave.setProperty("Patch", content, nullptr);
+        newAutoSave.setProperty("LastModified", time, nullptr);
+        autoSaveTree.addChild(newAutoSave, 0, nullptr);
+
+        if (autoSaveTree.getNumChildren() > maxAutosavedPatches) {
+            int64 oldestTime = std::numeric_limits<int64>::max();
+            int oldestIdx = -1;
+            int currentIdx = 0;
+            for (auto autoSave : autoSaveTree) {
+                auto modifiedTime = static_cast<int64>(autoSave.getProperty("LastModified"));
+                if (modifiedTime < oldestTime) {
+                    oldestTime = modifiedTime;
+                    oldestIdx = currentIdx;
                 }
+                currentIdx++;
             }
+            if (oldestIdx >= 0) {
+                autoSaveTree.removeChild(oldestIdx, nullptr);
+            }
+        }
+    }
+
+    static void writeCompressed(OutputStream& ostream, void const* data, size_t size)
+    {
+        MemoryOutputStream compressed;
+        {
+            GZIPCompressorOutputStream compressor(compressed);
+            compressor.write(data, size);
+        }
+
+        ostream.writeInt(static_cast<int>(compressed.getDataSize()));
+        ostream.write(compressed.getData(), compressed.getDataSize());
+    }
+
+    static void writeFullRecord(OutputStream& ostream, String const& path, String const& content, int64 time)
+    {
+        ostream.writeInt64(time);
+        ostream.writeString(path);
+        ostream.writeByte(FullRecord);
+        writeCompressed(ostream, content.toRawUTF8(), content.getNumBytesAsUTF8());
+    }
+
+    void appendToJournal(String const& path, String const& content, int64 time)
+    {
+        auto existingPatch = autoSaveTree.getChildWithProperty("Path", path);
+        auto const previousContent = existingPatch.getProperty("Patch").toString();
+        if (existingPatch.isValid() && previousContent == content)
+            return;
+
+        MemoryOutputStream record;
+        if (existingPatch.isValid()) {
+            // Only store the part between the unchanged start and end of the patch
+            auto const* previous = previousContent.toRawUTF8();
+            auto const* current = content.toRawUTF8();
+            auto const previousSize = previousContent.getNumBytesAsUTF8();
+            auto const currentSize = content.getNumBytesAsUTF8();
+
+            size_t prefix = 0;
+            while (prefix < previousSize && prefix < currentSize && previous[prefix] == current[prefix])
+                prefix++;
+
+            size_t suffix = 0;
+            while (suffix < previousSize - prefix && suffix < currentSize - prefix && previous[previousSize - suffix - 1] == current[currentSize - suffix - 1])
+                suffix++;
+
+            record.writeInt64(time);
+            record.writeString(path);
+            record.writeByte(DeltaRecord);
+            record.writeInt(static_cast<int>(prefix));
+            record.writeInt(static_cast<int>(suffix));
+            record.writeInt64(previousContent.hashCode64());
+            writeCompressed(record, current + prefix, currentSize - prefix - suffix);
+        } else {
+            writeFullRecord(record, path, content, time);
+        }
+
+        setAutosavedPatch(path, content, time);
+
+        if (++numJournalRecords > maxJournalRecords || autoSaveFile.getSize() + static_cast<int64>(record.getDataSize()) > maxJournalSize) {
+            compactJournal();
+            return;
         }
 
-        autoSaveFile.replaceWithText("");
         FileOutputStream ostream(autoSaveFile);
-        autoSaveTree.writeToStream(ostream);
+        if (!ostream.openedOk())
+            return;
+
+        if (ostream.getPosition() == 0) {
+            ostream.writeInt(journalMagic);
+            ostream.writeInt(journalVersion);
+        }
+
+        ostream.write(record.getData(), record.getDataSize());
+    }
+
+    // Rewrites the journal with only the latest version of every patch
+    static void compactJournal()
+    {
+        TemporaryFile tempFile(autoSaveFile);
+        {
+            FileOutputStream ostream(tempFile.getFile());
+            if (!ostream.openedOk())
+                return;
+
+            ostream.writeInt(journalMagic);
+            ostream.writeInt(journalVersion);
+            for (auto autoSave : autoSaveTree) {
+                writeFullRecord(ostream, autoSave.getProperty("Path").toString(), autoSave.getProperty("Patch").toString(), static_cast<int64>(autoSave.getProperty("LastModified")));
+            }
+        }
+
+        tempFile.overwriteTargetFileWithTemporary();
+        numJournalRecords = autoSaveTree.getNumChildren();
+    }
+
+    // Replays the journal to find the latest version of every patch
+    static void readJournal()
+    {
+        autoSaveTree = ValueTree("Autosave");
+        numJournalRecords = 0;
+
+        FileInputStream istream(autoSaveFile);
+        if (!istream.openedOk() || istream.readInt() != journalMagic)
+            return;
+
+        istream.readInt(); // Journal version, there is only one so far
+
+        while (!istream.isExhausted()) {
+            auto time = istream.readInt64();
+            auto path = istream.readString();
+            auto type = istream.readByte();
+
+            int prefix = 0, suffix = 0;
+            int64 previousHash = 0;
+            if (type == DeltaRecord) {
+                prefix = istream.readInt();
+                suffix = istream.readInt();
+                previousHash = istream.readInt64();
+            }
+
+            // A record can be cut off if we crashed while writing it
+            auto size = istream.readInt();
+            if (size < 0 || size > istream.getNumBytesRemaining())
+                break;
+
+            MemoryBlock compressed;
+            istream.readIntoMemoryBlock(compressed, size);
+
+            MemoryInputStream compressedStream(compressed, false);
+            GZIPDecompressorInputStream decompressor(compressedStream);
+            MemoryBlock data;
+            decompressor.readIntoMemoryBlock(data);
+
+            numJournalRecords++;
+
+            if (type == FullRecord) {
+                setAutosavedPatch(path, data.toString(), time);
+                continue;
+            }
+
+            // Deltas only apply to the content they were made from, which could be missing if another plugdata process wrote to the journal at the same time
+            auto const previousContent = autoSaveTree.getChildWithProperty("Path", path).getProperty("Patch").toString();
+            auto const previousSize = static_cast<int>(previousContent.getNumBytesAsUTF8());
+            if (previousContent.hashCode64() != previousHash || prefix < 0 || suffix < 0 || prefix + suffix > previousSize)
+                continue;
+
+            MemoryOutputStream content;
+            content.write(previousContent.toRawUTF8(), static_cast<size_t>(prefix));
+            content.write(data.getData(), data.getSize());
+            content.write(previousContent.toRawUTF8() + previousSize - suffix, static_cast<size_t>(suffix));
+            setAutosavedPatch(path, content.toUTF8(), time);
+        }
+    }
+
+    // Autosaves from before the journal were stored as a ValueTree with Base64 encoded patches
+    static void importLegacyAutosave()
+    {
+        FileInputStream istream(legacyAutoSaveFile);
+        auto legacyTree = ValueTree::readFromStream(istream);
+        if (!legacyTree.isValid())
+            return;
+
+        for (auto autoSave : legacyTree) {
+            MemoryOutputStream ostream;
+            Base64::convertFromBase64(ostream, autoSave.getProperty("Patch").toString());
+            auto content = String::fromUTF8(static_cast<char const*>(ostream.getData()), static_cast<int>(ostream.getDataSize()));
+            setAutosavedPatch(autoSave.getProperty("Path").toString(), content, static_cast<int64>(autoSave.getProperty("LastModified")));
+        }
+
+        compactJournal();
     }
 
     friend class AutosaveHistoryComponent;
@@ -184,9 +364,7 @@ class AutosaveHistoryComponent : public Component {
             openPatch.setColour(TextButton::buttonOnColourId, backgroundColour.contrasting(0.1f));
             openPatch.setColour(ComboBox::outlineColourId, Colours::transparentBlack);
             openPatch.onClick = [this, editor]() {
-                MemoryOutputStream ostream;
-                Base64::convertFromBase64(ostream, patch);
-                auto patch = editor->pd->loadPatch(String::fromUTF8(static_cast<const char*>(ostream.getData()), ostream.getDataSize()));
+                auto patch = editor->pd->loadPatch(this->patch, File(patchPath));
                 patch->setTitle(patchPath.fromLastOccurrenceOf("/", false, false));
                 patch->setCurrentFile(URL(patchPath));
                 editor->getTabComponent().triggerAsyncUpdate();
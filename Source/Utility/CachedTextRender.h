@@ -1,13 +1,302 @@
 #pragma once
 
+// Packs the rendered text of all objects into a few large textures, shared by everything that draws text with the same NanoVG context
+// With one texture per text object, large patches need thousands of textures, which all get created again on every zoom step.
+// We keep the pixels of every page in memory, so adding text only copies it into a page. Once per frame, we upload the part of every page that changed.
+// When all pages are full, the least recently used page is cleared, unless it was already used in the current frame.
+class TextAtlas {
+public:
+    struct Region {
+        int page;
+        Rectangle<int> area; // In pixels, inside the page
+    };
+
+    // Everything that influences the pixels of a text. The hash is only used to find an entry, the rest is compared to make sure it's really the same text
+    struct Key {
+        String layout; // Text, font, colour and layout width
+        Rectangle<int> bounds;
+        float scale;
+        uint64 hash;
+
+        bool operator==(Key const& other) const
+        {
+            return hash == other.hash && bounds == other.bounds && scale == other.scale && layout == other.layout;
+        }
+    };
+
+    struct Statistics {
+        int64 numRendered = 0;
+        int64 numUploads = 0;
+        int64 numEvictions = 0;
+    };
+
+    static TextAtlas& getForContext(NVGcontext* nvg)
+    {
+        auto& atlas = atlases[nvg];
+        if (!atlas)
+            atlas = std::make_unique<TextAtlas>(nvg);
+
+        return *atlas;
+    }
+
+    static void releaseContext(NVGcontext* nvg)
+    {
+        atlases.erase(nvg);
+    }
+
+    // Needs to be called after drawing, before the frame ends, so the textures are up to date when NanoVG flushes
+    static void uploadPendingChanges(NVGcontext* nvg)
+    {
+        auto it = atlases.find(nvg);
+        if (it == atlases.end())
+            return;
+
+        // Only upload the area that changed, a whole page is 4MB
+        // The backends skip to the right rows and columns themselves, so they get the pixels of the whole page
+        auto* params = nvgInternalParams(nvg);
+        auto& atlas = *it->second;
+        for (auto& page : atlas.pages) {
+            if (!page->dirtyArea.isEmpty() && page->texture.isValid()) {
+                auto const& area = page->dirtyArea;
+                params->renderUpdateTexture(params->userPtr, page->texture.getImageId(), area.getX(), area.getY(), area.getWidth(), area.getHeight(), reinterpret_cast<unsigned char const*>(page->pixels.data()));
+                page->dirtyArea = {};
+                atlas.statistics.numUploads++;
+            }
+        }
+
+        atlas.currentFrame++;
+    }
+
+    explicit TextAtlas(NVGcontext* context)
+        : nvg(context)
+    {
+    }
+
+    // Returns where the text is in the atlas, rendering it first if we don't have it yet
+    // Returns nothing if it's too large for a page, or if there is no room left that isn't in use in this frame
+    std::optional<Region> getRegion(Key const& key, int width, int height, std::function<void(Graphics&)> const& renderCall)
+    {
+        if (auto it = entries.find(key.hash); it != entries.end() && it->second.key == key) {
+            auto& page = *pages[it->second.region.page];
+            if (page.texture.isValid()) {
+                page.lastUsedFrame = currentFrame;
+                return it->second.region;
+            }
+        }
+
+        if (width <= 0 || height <= 0 || width + 2 > pageSize || height + 2 > pageSize)
+            return std::nullopt;
+
+        auto region = allocate(width + 2, height + 2);
+        if (!region)
+            return std::nullopt;
+
+        // Leave a transparent pixel around every region, so filtering doesn't pick up the neighbours
+        region->area = region->area.reduced(1);
+
+        Image image(Image::ARGB, width, height, true);
+        {
+            Graphics g(image);
+            renderCall(g);
+        }
+
+        // NanoVG wants premultiplied RGBA, JUCE gives us premultiplied ARGB
+        auto& page = *pages[region->page];
+        Image::BitmapData imageData(image, Image::BitmapData::readOnly);
+        for (int y = 0; y < height; y++) {
+            auto const* source = reinterpret_cast<uint32 const*>(imageData.getLinePointer(y));
+            auto* destination = page.pixels.data() + (region->area.getY() + y) * pageSize + region->area.getX();
+            for (int x = 0; x < width; x++) {
+                auto const argb = source[x];
+                destination[x] = (argb & 0xff00ff00) | ((argb >> 16) & 0xff) | ((argb & 0xff) << 16);
+            }
+        }
+
+        page.dirtyArea = page.dirtyArea.isEmpty() ? region->area : page.dirtyArea.getUnion(region->area);
+        page.lastUsedFrame = currentFrame;
+        entries[key.hash] = { key, *region };
+        statistics.numRendered++;
+
+        return region;
+    }
+
+    int getImageId(int page) const
+    {
+        return pages[page]->texture.getImageId();
+    }
+
+    static constexpr int getPageSize()
+    {
+        return pageSize;
+    }
+
+    Statistics getStatistics() const
+    {
+        return statistics;
+    }
+
+private:
+    struct Shelf {
+        int y;
+        int height;
+        int x = 0;
+    };
+
+    struct Page {
+        std::vector<uint32> pixels = std::vector<uint32>(pageSize * pageSize, 0);
+        std::vector<Shelf> shelves;
+        int nextShelfY = 0;
+        uint64 lastUsedFrame = 0;
+        Rectangle<int> dirtyArea; // Part of the page that needs to be uploaded
+        NVGImage texture;
+    };
+
+    struct Entry {
+        Key key;
+        Region region;
+    };
+
+    std::optional<Region> allocate(int width, int height)
+    {
+        for (int i = 0; i < static_cast<int>(pages.size()); i++) {
+            if (auto area = allocateInPage(i, width, height))
+                return Region { i, *area };
+        }
+
+        if (static_cast<int>(pages.size()) < maxPages) {
+            createPage();
+            if (auto area = allocateInPage(static_cast<int>(pages.size()) - 1, width, height))
+                return Region { static_cast<int>(pages.size()) - 1, *area };
+            return std::nullopt;
+        }
+
+        // Text that was drawn earlier in this frame would get overwritten, so we can only clear pages that weren't used yet
+        auto leastRecentlyUsed = std::min_element(pages.begin(), pages.end(), [](auto const& a, auto const& b) {
+            return a->lastUsedFrame < b->lastUsedFrame;
+        });
+
+        if ((*leastRecentlyUsed)->lastUsedFrame >= currentFrame)
+            return std::nullopt;
+
+        auto const pageIndex = static_cast<int>(leastRecentlyUsed - pages.begin());
+        clearPage(pageIndex);
+        statistics.numEvictions++;
+
+        if (auto area = allocateInPage(pageIndex, width, height))
+            return Region { pageIndex, *area };
+
+        return std::nullopt;
+    }
+
+    // Simple shelf packing: text regions all have similar heights, so this wastes very little space
+    std::optional<Rectangle<int>> allocateInPage(int pageIndex, int width, int height)
+    {
+        auto& page = *pages[pageIndex];
+        if (!page.texture.isValid()) {
+            clearPage(pageIndex);
+            page.texture.nvg = nvg;
+            page.texture.imageId = nvgCreateImageRGBA(nvg, pageSize, pageSize, NVG_IMAGE_PREMULTIPLIED, reinterpret_cast<uint8 const*>(page.pixels.data()));
+            page.texture.imageWidth = pageSize;
+            page.texture.imageHeight = pageSize;
+        }
+
+        for (auto& shelf : page.shelves) {
+            if (height <= shelf.height && height * 5 >= shelf.height * 4 && shelf.x + width <= pageSize) {
+                auto area = Rectangle<int>(shelf.x, shelf.y, width, height);
+                shelf.x += width;
+                return area;
+            }
+        }
+
+        if (page.nextShelfY + height > pageSize)
+            return std::nullopt;
+
+        page.shelves.push_back({ page.nextShelfY, height, width });
+        page.nextShelfY += height;
+        return Rectangle<int>(0, page.shelves.back().y, width, height);
+    }
+
+    void createPage()
+    {
+        auto const pageIndex = static_cast<int>(pages.size());
+        auto& page = *pages.emplace_back(std::make_unique<Page>());
+
+        // The texture gets deleted when the context is lost or the theme changes, so we start over with this page
+        page.texture.onImageInvalidate = [this, pageIndex]() {
+            clearPage(pageIndex);
+        };
+    }
+
+    void clearPage(int pageIndex)
+    {
+        auto& page = *pages[pageIndex];
+        std::fill(page.pixels.begin(), page.pixels.end(), 0);
+        page.shelves.clear();
+        page.nextShelfY = 0;
+        page.dirtyArea = Rectangle<int>(pageSize, pageSize);
+
+        for (auto it = entries.begin(); it != entries.end();) {
+            if (it->second.region.page == pageIndex) {
+                it = entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    static constexpr int pageSize = 1024;
+    static constexpr int maxPages = 16;
+
+    NVGcontext* nvg;
+    std::vector<std::unique_ptr<Page>> pages;
+    std::unordered_map<uint64, Entry> entries;
+    uint64 currentFrame = 1;
+    Statistics statistics;
+
+    static inline std::map<NVGcontext*, std::unique_ptr<TextAtlas>> atlases;
+};
+
 class CachedTextRender {
 public:
     CachedTextRender() = default;
 
     void renderText(NVGcontext* nvg, Rectangle<int> const& bounds, float scale)
     {
+        auto const imageBounds = Rectangle<int>(bounds.getX(), bounds.getY(), bounds.getWidth() + 3, bounds.getHeight());
+
+        // Text in the atlas is rendered at one of a few fixed scales, and drawn slightly scaled down, so zooming reuses it instead of rendering everything again
+        auto const rasterScale = getRasterScale(scale);
+        int const width = std::floor(imageBounds.getWidth() * rasterScale);
+        int const height = std::floor(imageBounds.getHeight() * rasterScale);
+
+        // Everything that influences the pixels is part of the key, so objects that show the same text can share it
+        auto hash = layoutHash;
+        for (auto const value : { static_cast<uint64>(imageBounds.getX()), static_cast<uint64>(imageBounds.getY()), static_cast<uint64>(imageBounds.getWidth()), static_cast<uint64>(imageBounds.getHeight()), static_cast<uint64>(roundToInt(rasterScale * 1000.0f)) }) {
+            hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+        }
+
+        auto& atlas = TextAtlas::getForContext(nvg);
+        auto region = atlas.getRegion({ layoutKey, imageBounds, rasterScale, hash }, width, height, [this, imageBounds, rasterScale](Graphics& g) {
+            drawLayout(g, imageBounds, rasterScale);
+        });
+
+        if (region) {
+            // Release the texture from the fallback path, now that we don't need it anymore
+            if (image.isValid())
+                image = NVGImage();
+
+            auto const pageSize = TextAtlas::getPageSize() / rasterScale;
+            NVGScopedState scopedState(nvg);
+            nvgIntersectScissor(nvg, bounds.getX(), bounds.getY(), bounds.getWidth(), bounds.getHeight());
+            nvgIntersectScissor(nvg, 0, 0, width / rasterScale, height / rasterScale);
+            nvgFillPaint(nvg, nvgImagePattern(nvg, -region->area.getX() / rasterScale, -region->area.getY() / rasterScale, pageSize, pageSize, 0, atlas.getImageId(region->page), 1.0f));
+            nvgFillRect(nvg, bounds.getX(), bounds.getY(), bounds.getWidth() + 3, bounds.getHeight());
+            return;
+        }
+
+        // The text didn't fit in the atlas, so it gets its own image
         if (updateImage || !image.isValid() || lastRenderBounds != bounds || lastScale != scale) {
-            renderTextToImage(nvg, Rectangle<int>(bounds.getX(), bounds.getY(), bounds.getWidth() + 3, bounds.getHeight()), scale);
+            renderTextToImage(nvg, imageBounds, scale);
             lastRenderBounds = bounds;
             lastScale = scale;
             updateImage = false;
@@ -39,6 +328,9 @@ public:
             lastTextHash = textHash;
             lastColour = colour;
             updateImage = true;
+
+            layoutKey = text + "\x1f" + font.toString() + "\x1f" + colour.toString() + "\x1f" + String(width);
+            layoutHash = static_cast<uint64>(layoutKey.hashCode64());
         }
 
         return needsUpdate;
@@ -50,9 +342,7 @@ public:
         int height = std::floor(bounds.getHeight() * scale);
 
         image = NVGImage(nvg, width, height, [this, bounds, scale](Graphics& g) {
-            g.addTransform(AffineTransform::scale(scale, scale));
-            g.reduceClipRegion(bounds.withTrimmedRight(4)); // If it touches the edges of the image, it'll look bad
-            layout.draw(g, bounds.toFloat());
+            drawLayout(g, bounds, scale);
         });
     }
 
@@ -62,6 +352,21 @@ public:
     }
 
 private:
+    // Rounds the scale up to the next half octave: 1, 1.41, 2, 2.83, 4 and so on
+    // Common scales like 1x and 2x are rendered exactly, others are at most 1.41 times too large, which still looks sharp when scaled down
+    static float getRasterScale(float scale)
+    {
+        auto const step = std::ceil(std::log2(std::max(scale, 0.125f)) * 2.0f - 0.001f);
+        return std::pow(2.0f, step / 2.0f);
+    }
+
+    void drawLayout(Graphics& g, Rectangle<int> const& bounds, float scale) const
+    {
+        g.addTransform(AffineTransform::scale(scale, scale));
+        g.reduceClipRegion(bounds.withTrimmedRight(4)); // If it touches the edges of the image, it'll look bad
+        layout.draw(g, bounds.toFloat());
+    }
+
     NVGImage image;
     hash32 lastTextHash = 0;
     float lastScale = 1.0f;
@@ -69,6 +374,8 @@ private:
     int lastWidth = 0;
     int idealWidth = 0, idealHeight = 0;
     Rectangle<int> lastRenderBounds;
+    String layoutKey;
+    uint64 layoutHash = 0;
 
     TextLayout layout;
     bool updateImage = false;
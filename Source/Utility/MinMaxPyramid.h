@@ -0,0 +1,133 @@
+/*
+ // Copyright (c) 2021-2022 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+// Min/max mipmap over the values of an array
+// This lets us find the minimum and maximum of any range of values without reading all of them, so we can draw huge arrays as an envelope without losing peaks
+// The first level holds the min/max of every block of values, every next level combines a few entries of the level below it
+class MinMaxPyramid {
+public:
+    struct MinMax {
+        float min = std::numeric_limits<float>::infinity();
+        float max = -std::numeric_limits<float>::infinity();
+
+        void add(float value)
+        {
+            min = std::min(min, value);
+            max = std::max(max, value);
+        }
+
+        void add(MinMax const& other)
+        {
+            min = std::min(min, other.min);
+            max = std::max(max, other.max);
+        }
+
+        bool isEmpty() const
+        {
+            return min > max;
+        }
+    };
+
+    // Resizes the pyramid and recomputes it for all values
+    void rebuild(float const* values, size_t size)
+    {
+        numValues = size;
+        levels.clear();
+
+        auto levelSize = (size + blockSize - 1) / blockSize;
+        while (levelSize > 0) {
+            levels.emplace_back(levelSize);
+            if (levelSize <= fanOut)
+                break;
+            levelSize = (levelSize + fanOut - 1) / fanOut;
+        }
+
+        update(values, 0, size);
+    }
+
+    // Recomputes the pyramid for the values in the range [start, end)
+    void update(float const* values, size_t start, size_t end)
+    {
+        end = std::min(end, numValues);
+        if (levels.empty() || start >= end)
+            return;
+
+        auto first = start / blockSize;
+        auto last = (end - 1) / blockSize;
+
+        for (auto block = first; block <= last; block++) {
+            MinMax result;
+            auto const blockEnd = std::min(numValues, (block + 1) * blockSize);
+            for (auto i = block * blockSize; i < blockEnd; i++) {
+                result.add(values[i]);
+            }
+            levels[0][block] = result;
+        }
+
+        for (size_t level = 1; level < levels.size(); level++) {
+            first /= fanOut;
+            last /= fanOut;
+
+            auto const& below = levels[level - 1];
+            for (auto entry = first; entry <= last; entry++) {
+                MinMax result;
+                auto const entryEnd = std::min(below.size(), (entry + 1) * fanOut);
+                for (auto i = entry * fanOut; i < entryEnd; i++) {
+                    result.add(below[i]);
+                }
+                levels[level][entry] = result;
+            }
+        }
+    }
+
+    // Returns the min and max of the values in the range [start, end)
+    MinMax getMinMax(float const* values, size_t start, size_t end) const
+    {
+        MinMax result;
+        end = std::min(end, numValues);
+
+        // Values that don't fill a whole block are read directly
+        while (start < end && start % blockSize != 0)
+            result.add(values[start++]);
+        while (end > start && end % blockSize != 0)
+            result.add(values[--end]);
+
+        auto first = start / blockSize;
+        auto last = end / blockSize;
+        for (size_t level = 0; first < last && level < levels.size(); level++) {
+            auto const& entries = levels[level];
+            if (level == levels.size() - 1) {
+                for (; first < last; first++)
+                    result.add(entries[first]);
+                break;
+            }
+
+            while (first < last && first % fanOut != 0)
+                result.add(entries[first++]);
+            while (last > first && last % fanOut != 0)
+                result.add(entries[--last]);
+
+            first /= fanOut;
+            last /= fanOut;
+        }
+
+        return result;
+    }
+
+    size_t getNumValues() const
+    {
+        return numValues;
+    }
+
+private:
+    static constexpr size_t blockSize = 16;
+    static constexpr size_t fanOut = 4;
+
+    size_t numValues = 0;
+    std::vector<std::vector<MinMax>> levels;
+};
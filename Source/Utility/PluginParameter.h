@@ -82,8 +82,24 @@ public:
 
     void setName(String const& newName)
     {
-        ScopedLock lock(nameLock);
-        parameterName = newName;
+        {
+            ScopedLock lock(nameLock);
+            parameterName = newName;
+        }
+
+        updateReceiverSymbol();
+    }
+
+    // Looks up the symbol that the value gets sent to, so the audio thread doesn't have to hash the name for every change
+    // Needs to be called once after the pd instance is created, and is called again on every rename
+    void updateReceiverSymbol()
+    {
+        receiverSymbol = processor.generateSymbol(getTitle());
+    }
+
+    t_symbol* getReceiverSymbol() const
+    {
+        return receiverSymbol;
     }
 
     String getName(int maximumStringLength) const override
@@ -105,6 +121,10 @@ public:
     void setEnabled(bool shouldBeEnabled)
     {
         enabled = shouldBeEnabled;
+
+        // Changes that happened while disabled have not been sent yet
+        if (shouldBeEnabled)
+            markDirty();
     }
 
     NormalisableRange<float> const& getNormalisableRange() const override
@@ -129,6 +149,7 @@ public:
     {
         auto range = getNormalisableRange();
         value = std::clamp(newValue, range.start, range.end);
+        markDirty();
         sendValueChangedMessageToListeners(getValue());
     }
 
@@ -142,6 +163,7 @@ public:
     {
         auto range = getNormalisableRange();
         value = range.convertFrom0to1(newValue);
+        markDirty();
     }
 
     float getDefaultValue() const override
@@ -317,6 +339,13 @@ public:
     }
 
 private:
+    void markDirty()
+    {
+        // Only -1 while the parameter hasn't been added to the processor yet
+        if (auto const parameterIndex = getParameterIndex(); parameterIndex >= 0)
+            processor.setParameterDirty(parameterIndex);
+    }
+
     float lastValue = 0.0f;
     float const defaultValue;
 
@@ -325,6 +354,7 @@ private:
     std::atomic<int> index;
     std::atomic<float> value;
     std::atomic<bool> enabled = false;
+    std::atomic<t_symbol*> receiverSymbol = nullptr;
 
     CriticalSection nameLock;
     String parameterName;
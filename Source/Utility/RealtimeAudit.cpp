@@ -0,0 +1,216 @@
+/*
+ // Copyright (c) 2021-2022 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include <juce_core/juce_core.h>
+using namespace juce;
+
+#include "RealtimeAudit.h"
+
+#if ENABLE_REALTIME_AUDIT
+
+#    include <new>
+#    include <cstdlib>
+#    include <cerrno>
+
+#    if defined(__GLIBC__)
+#        include <dlfcn.h>
+#        include <pthread.h>
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+}
+#    endif
+
+namespace {
+
+// These need to be constant-initialised, since they are also used by allocations that happen before static initialisation
+thread_local int audioThreadDepth = 0;
+thread_local bool isReporting = false;
+
+// The list of violations is protected by a spinlock, so that reporting doesn't go through the mutex hook
+SpinLock violationsLock;
+std::vector<RealtimeAudit::Violation>* violations = nullptr;
+constexpr size_t maxViolations = 256;
+
+void reportViolation(char const* type)
+{
+    if (audioThreadDepth <= 0 || isReporting)
+        return;
+
+    // Anything we do from here on allocates or locks, so don't report ourselves
+    isReporting = true;
+
+    auto stackTrace = SystemStats::getStackBacktrace();
+
+    {
+        SpinLock::ScopedLockType lock(violationsLock);
+        if (!violations)
+            violations = new std::vector<RealtimeAudit::Violation>();
+
+        if (violations->size() < maxViolations)
+            violations->push_back({ type, stackTrace });
+    }
+
+    isReporting = false;
+}
+
+}
+
+void RealtimeAudit::enterAudioThread()
+{
+    audioThreadDepth++;
+}
+
+void RealtimeAudit::exitAudioThread()
+{
+    audioThreadDepth--;
+}
+
+std::vector<RealtimeAudit::Violation> RealtimeAudit::getViolations()
+{
+    SpinLock::ScopedLockType lock(violationsLock);
+    return violations ? *violations : std::vector<Violation>();
+}
+
+void RealtimeAudit::clearViolations()
+{
+    SpinLock::ScopedLockType lock(violationsLock);
+    if (violations)
+        violations->clear();
+}
+
+#    if defined(__GLIBC__)
+
+using PthreadMutexLock = int (*)(pthread_mutex_t*);
+static std::atomic<PthreadMutexLock> realPthreadMutexLock = nullptr;
+
+// The definitions in the executable take precedence over the ones in libc, so this catches allocations from C code like Pd too
+extern "C" {
+void* malloc(size_t size) noexcept
+{
+    reportViolation("malloc");
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept
+{
+    reportViolation("calloc");
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) noexcept
+{
+    reportViolation("realloc");
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) noexcept
+{
+    reportViolation("memalign");
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size) noexcept
+{
+    reportViolation("posix_memalign");
+    *ptr = __libc_memalign(alignment, size);
+    return *ptr ? 0 : ENOMEM;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept
+{
+    reportViolation("aligned_alloc");
+    return __libc_memalign(alignment, size);
+}
+
+void free(void* ptr) noexcept
+{
+    if (ptr)
+        reportViolation("free");
+    __libc_free(ptr);
+}
+
+// Only blocking locks are a problem, try-locks are fine on the audio thread
+int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept
+{
+    // Not a function-local static: initialising that could take a mutex, which would end up back here
+    auto* lock = realPthreadMutexLock.load(std::memory_order_relaxed);
+    if (!lock) {
+        lock = reinterpret_cast<PthreadMutexLock>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+        realPthreadMutexLock.store(lock, std::memory_order_relaxed);
+    }
+
+    reportViolation("pthread_mutex_lock");
+    return lock(mutex);
+}
+}
+
+#    else
+
+// Without glibc, we can't portably replace malloc, so we only catch allocations that go through operator new and delete
+void* operator new(size_t size)
+{
+    reportViolation("operator new");
+    if (auto* ptr = std::malloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    reportViolation("operator new[]");
+    if (auto* ptr = std::malloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::nothrow_t const&) noexcept
+{
+    reportViolation("operator new");
+    return std::malloc(size);
+}
+
+void* operator new[](size_t size, std::nothrow_t const&) noexcept
+{
+    reportViolation("operator new[]");
+    return std::malloc(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    if (ptr)
+        reportViolation("operator delete");
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    if (ptr)
+        reportViolation("operator delete[]");
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    if (ptr)
+        reportViolation("operator delete");
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+    if (ptr)
+        reportViolation("operator delete[]");
+    std::free(ptr);
+}
+
+#    endif
+
+#endif
@@ -0,0 +1,51 @@
+/*
+ // Copyright (c) 2021-2022 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+// Test build mode that finds code on the audio thread that isn't realtime-safe
+// When building with ENABLE_REALTIME_AUDIT, every memory allocation, deallocation and mutex lock that happens inside a
+// ScopedAudioThread gets recorded together with a stack trace. In normal builds, this compiles to nothing.
+// On glibc we intercept malloc/free and pthread_mutex_lock. Elsewhere, we can only intercept C++ allocations through operator new/delete.
+struct RealtimeAudit {
+    struct Violation {
+        String type;
+        String stackTrace;
+    };
+
+#if ENABLE_REALTIME_AUDIT
+    struct ScopedAudioThread {
+        ScopedAudioThread()
+        {
+            enterAudioThread();
+        }
+
+        ~ScopedAudioThread()
+        {
+            exitAudioThread();
+        }
+    };
+
+    static void enterAudioThread();
+    static void exitAudioThread();
+
+    static std::vector<Violation> getViolations();
+    static void clearViolations();
+#else
+    struct ScopedAudioThread {
+        ScopedAudioThread() { }
+    };
+
+    static std::vector<Violation> getViolations()
+    {
+        return {};
+    }
+
+    static void clearViolations()
+    {
+    }
+#endif
+};
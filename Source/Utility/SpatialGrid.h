@@ -0,0 +1,179 @@
+/*
+ // Copyright (c) 2021-2022 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+// Uniform grid that keeps track of which items are in which area of the canvas
+// This lets us find all objects or connections in an area without iterating over all of them, which matters a lot for large patches
+// Items are returned in their z-order: by the order that was set with setOrder, then by the order in which they were added
+template<typename T>
+class SpatialGrid {
+public:
+    explicit SpatialGrid(int size = 256)
+        : cellSize(size)
+    {
+    }
+
+    void update(T* item, Rectangle<int> bounds)
+    {
+        auto& entry = entries[item];
+        auto const newCells = getCellRange(bounds);
+
+        if (entry.isIndexed && entry.cells == newCells) {
+            entry.bounds = bounds;
+            return;
+        }
+
+        if (entry.isIndexed) {
+            removeFromCells(item, entry.cells);
+        } else {
+            entry.sequence = nextSequence++;
+        }
+
+        addToCells(item, newCells);
+        entry.bounds = bounds;
+        entry.cells = newCells;
+        entry.isIndexed = true;
+    }
+
+    void remove(T* item)
+    {
+        auto it = entries.find(item);
+        if (it == entries.end())
+            return;
+
+        if (it->second.isIndexed) {
+            removeFromCells(item, it->second.cells);
+        }
+
+        entries.erase(it);
+    }
+
+    void setOrder(T* item, int order)
+    {
+        if (auto it = entries.find(item); it != entries.end()) {
+            it->second.order = order;
+        }
+    }
+
+    // Returns all items with bounds that intersect the area, in z-order
+    std::vector<T*> query(Rectangle<int> area) const
+    {
+        std::vector<Entry const*> found;
+        auto const cellRange = getCellRange(area);
+
+        auto addIfIntersecting = [&area, &found](Entry const& entry) {
+            if (entry.bounds.intersects(area) || area.contains(entry.bounds.getPosition()))
+                found.push_back(&entry);
+        };
+
+        // When the area covers more cells than we have in use, it's faster to check every item once
+        if (static_cast<int64>(cellRange.getWidth()) * cellRange.getHeight() > static_cast<int64>(cells.size())) {
+            for (auto const& [item, entry] : entries) {
+                if (entry.isIndexed)
+                    addIfIntersecting(entry);
+            }
+        } else {
+            for (int y = cellRange.getY(); y < cellRange.getBottom(); y++) {
+                for (int x = cellRange.getX(); x < cellRange.getRight(); x++) {
+                    auto it = cells.find(getCellKey(x, y));
+                    if (it == cells.end())
+                        continue;
+
+                    for (auto* item : it->second) {
+                        auto const& entry = entries.at(item);
+
+                        // Items that span multiple cells are only checked in the first cell that's inside the area, to prevent duplicates
+                        if (jmax(entry.cells.getX(), cellRange.getX()) != x || jmax(entry.cells.getY(), cellRange.getY()) != y)
+                            continue;
+
+                        addIfIntersecting(entry);
+                    }
+                }
+            }
+        }
+
+        std::sort(found.begin(), found.end(), [](Entry const* a, Entry const* b) {
+            return a->order != b->order ? a->order < b->order : a->sequence < b->sequence;
+        });
+
+        std::vector<T*> result;
+        result.reserve(found.size());
+        for (auto* entry : found) {
+            result.push_back(entry->item);
+        }
+
+        return result;
+    }
+
+    void clear()
+    {
+        cells.clear();
+        entries.clear();
+    }
+
+private:
+    struct Entry {
+        T* item = nullptr;
+        Rectangle<int> bounds;
+        Rectangle<int> cells;
+        int order = std::numeric_limits<int>::max();
+        uint64 sequence = 0;
+        bool isIndexed = false;
+    };
+
+    // Range of cells covered by the bounds, empty bounds still occupy the cell they're in
+    Rectangle<int> getCellRange(Rectangle<int> bounds) const
+    {
+        auto const x1 = floorToCell(bounds.getX());
+        auto const y1 = floorToCell(bounds.getY());
+        auto const x2 = floorToCell(jmax(bounds.getX(), bounds.getRight() - 1));
+        auto const y2 = floorToCell(jmax(bounds.getY(), bounds.getBottom() - 1));
+        return { x1, y1, x2 - x1 + 1, y2 - y1 + 1 };
+    }
+
+    int floorToCell(int position) const
+    {
+        return position >= 0 ? position / cellSize : (position - cellSize + 1) / cellSize;
+    }
+
+    static int64 getCellKey(int x, int y)
+    {
+        return (static_cast<int64>(x) << 32) | static_cast<uint32>(y);
+    }
+
+    void addToCells(T* item, Rectangle<int> cellRange)
+    {
+        entries[item].item = item;
+        for (int y = cellRange.getY(); y < cellRange.getBottom(); y++) {
+            for (int x = cellRange.getX(); x < cellRange.getRight(); x++) {
+                cells[getCellKey(x, y)].push_back(item);
+            }
+        }
+    }
+
+    void removeFromCells(T* item, Rectangle<int> cellRange)
+    {
+        for (int y = cellRange.getY(); y < cellRange.getBottom(); y++) {
+            for (int x = cellRange.getX(); x < cellRange.getRight(); x++) {
+                auto it = cells.find(getCellKey(x, y));
+                if (it == cells.end())
+                    continue;
+
+                auto& items = it->second;
+                items.erase(std::remove(items.begin(), items.end(), item), items.end());
+                if (items.empty())
+                    cells.erase(it);
+            }
+        }
+    }
+
+    int cellSize;
+    uint64 nextSequence = 0;
+
+    std::unordered_map<int64, std::vector<T*>> cells;
+    std::unordered_map<T*, Entry> entries;
+};
@@ -5,17 +5,44 @@
 #include "Sidebar/Sidebar.h" // So we can read and clear the console
 #include "Objects/ObjectBase.h" // So we can interact with object GUIs
 #include "PluginEditor.h"
+#include "PluginProcessor.h"
+#include "Pd/Library.h"
+#include "Utility/SpatialGrid.h"
+#include "Utility/MinMaxPyramid.h"
+#include "Pd/MessageListener.h"
+#include "Utility/PluginParameter.h"
+#include "Utility/RealtimeAudit.h"
+#include "Utility/MidiDeviceManager.h"
+#include "Utility/CachedTextRender.h"
+
+#include <numeric>
 
 String loggedErrors;
 
+// Checks that failed before the help files were opened, these make the whole test run fail
+StringArray failedChecks;
+
 void openHelpfilesRecursively(TabComponent& tabbar, std::vector<File>& helpFiles)
 {
     static int numProcessed = 0;
     
     if(helpFiles.empty())
     {
-        std::cout << "TEST COMPLETED SUCCESFULLY" << std::endl;
         ProjectInfo::appDataDir.getChildFile("console-errors.md").replaceWithText(loggedErrors);
+
+        if(!failedChecks.isEmpty())
+        {
+            std::cout << "TEST FAILED: " << failedChecks.joinIntoString(", ") << std::endl;
+
+            // Quit with a non-zero exit code, so the test run fails
+            if (auto* app = JUCEApplicationBase::getInstance()) {
+                app->setApplicationReturnValue(1);
+                JUCEApplicationBase::quit();
+            }
+            return;
+        }
+
+        std::cout << "TEST COMPLETED SUCCESFULLY" << std::endl;
         return;
     }
 
@@ -106,8 +133,840 @@ void openHelpfilesRecursively(TabComponent& tabbar, std::vector<File>& helpFiles
     });
 }
 
+// Types every object name one character at a time, like in an object box, and reports the autocomplete latency
+void runAutocompleteBenchmark(pd::Library& library, File const& patchDirectory)
+{
+    std::vector<double> latencies;
+    for (auto& name : library.getAllObjects()) {
+        for (int i = 1; i <= name.length(); i++) {
+            auto start = Time::getHighResolutionTicks();
+            library.autocomplete(name.substring(0, i), patchDirectory);
+            latencies.push_back(Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1000.0);
+        }
+    }
+
+    if (latencies.empty())
+        return;
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        return latencies[std::min<size_t>(latencies.size() - 1, static_cast<size_t>(p * latencies.size()))];
+    };
+
+    std::cout << "AUTOCOMPLETE BENCHMARK: " << latencies.size() << " queries, p50 " << percentile(0.5) << "ms, p99 " << percentile(0.99) << "ms, max " << latencies.back() << "ms" << std::endl;
+}
+
+// Compares finding the objects inside the view on a large synthetic patch, like we do every frame, using the spatial grid vs. iterating over all objects
+void runCanvasCullingBenchmark(int numObjects)
+{
+    struct FakeObject {
+        Rectangle<int> bounds;
+    };
+
+    Random random(numObjects);
+    std::vector<FakeObject> objects(numObjects);
+    SpatialGrid<FakeObject> grid;
+
+    auto const patchSize = static_cast<int>(std::sqrt(numObjects) * 120);
+    for (auto& object : objects) {
+        object.bounds = Rectangle<int>(random.nextInt(patchSize), random.nextInt(patchSize), 40 + random.nextInt(80), 25);
+        grid.update(&object, object.bounds);
+    }
+
+    int numFound = 0;
+    auto linearTime = 0.0;
+    auto gridTime = 0.0;
+    for (int frame = 0; frame < 1000; frame++) {
+        // Scrolling across a zoomed-in view
+        auto view = Rectangle<int>(0, 0, 800, 600).withPosition(frame * patchSize / 1000, frame * patchSize / 1000);
+
+        auto start = Time::getHighResolutionTicks();
+        for (auto& object : objects) {
+            if (object.bounds.intersects(view))
+                numFound++;
+        }
+        auto middle = Time::getHighResolutionTicks();
+        numFound += static_cast<int>(grid.query(view).size());
+        auto end = Time::getHighResolutionTicks();
+
+        linearTime += Time::highResolutionTicksToSeconds(middle - start);
+        gridTime += Time::highResolutionTicksToSeconds(end - middle);
+    }
+
+    std::cout << "CANVAS CULLING BENCHMARK: " << numObjects << " objects, linear " << linearTime << "ms/frame, grid " << gridTime << "ms/frame (" << numFound << ")" << std::endl;
+}
+
+// Sends messages to a few hundred animated GUI objects, and measures how long it takes to enqueue and dispatch one frame of messages
+void runMessageDispatcherBenchmark(int messagesPerFrame)
+{
+    struct CountingListener : public pd::MessageListener {
+        void receiveMessage(t_symbol* symbol, pd::Atom const atoms[8], int numAtoms) override
+        {
+            numReceived++;
+        }
+
+        int numReceived = 0;
+    };
+
+    int const numTargets = 500;
+    std::vector<CountingListener> listeners(numTargets);
+    std::vector<int> targets(numTargets);
+
+    pd::MessageDispatcher dispatcher;
+    dispatcher.setBlockMessages(false);
+    for (int i = 0; i < numTargets; i++) {
+        dispatcher.addMessageListener(&targets[i], &listeners[i]);
+    }
+
+    t_symbol* selectors[2] = { gensym("float"), gensym("list") };
+    t_atom atoms[2];
+    SETFLOAT(atoms, 0.5f);
+    SETFLOAT(atoms + 1, 1.0f);
+
+    auto enqueueTime = 0.0;
+    auto dequeueTime = 0.0;
+    int const numFrames = 100;
+    for (int frame = 0; frame < numFrames; frame++) {
+        auto start = Time::getHighResolutionTicks();
+        for (int i = 0; i < messagesPerFrame; i++) {
+            dispatcher.enqueueMessage(&targets[i % numTargets], selectors[i & 1], 2, atoms);
+        }
+        auto middle = Time::getHighResolutionTicks();
+        dispatcher.dequeueMessages();
+        auto end = Time::getHighResolutionTicks();
+
+        enqueueTime += Time::highResolutionTicksToSeconds(middle - start);
+        dequeueTime += Time::highResolutionTicksToSeconds(end - middle);
+    }
+
+    std::cout << "MESSAGE DISPATCHER BENCHMARK: " << messagesPerFrame << " messages/frame, enqueue " << enqueueTime * 1000.0 / numFrames << "ms/frame, dispatch " << dequeueTime * 1000.0 / numFrames << "ms/frame" << std::endl;
+}
+
+// Generates a patch of about the given size, with message boxes connected to objects
+String generatePatchText(int patchKilobytes)
+{
+    MemoryOutputStream patchText;
+    patchText << "#N canvas 0 0 1000 800 12;\n";
+
+    int numObjects = 0;
+    while (patchText.getDataSize() < static_cast<size_t>(patchKilobytes) * 1024) {
+        auto const x = (numObjects % 20) * 80;
+        auto const y = (numObjects / 20) * 40;
+        if (numObjects % 2 == 0) {
+            patchText << "#X msg " << x << " " << y << " " << numObjects << " 0.5 bang;\n";
+        } else {
+            patchText << "#X obj " << x << " " << y << " + " << numObjects << ";\n";
+            patchText << "#X connect " << numObjects - 1 << " 0 " << numObjects << " 0;\n";
+        }
+        numObjects++;
+    }
+
+    return patchText.toString();
+}
+
+// Saves the DAW state with a generated patch of the given size, and measures how long an audio thread that wakes up every millisecond has to wait for the audio lock
+// The second save shows the cost of saving a patch that didn't change since the last save
+void runStateSerialisationBenchmark(PluginProcessor* pd, int patchKilobytes)
+{
+    auto patch = pd->loadPatch(generatePatchText(patchKilobytes));
+    if (!patch)
+        return;
+
+    auto measureSave = [pd](MemoryBlock& state) {
+        std::atomic<bool> isSaving = true;
+        double maxLockWait = 0.0;
+
+        std::thread audioThread([pd, &isSaving, &maxLockWait]() {
+            while (isSaving) {
+                auto start = Time::getHighResolutionTicks();
+                pd->lockAudioThread();
+                maxLockWait = std::max(maxLockWait, Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1000.0);
+                pd->unlockAudioThread();
+                Thread::sleep(1);
+            }
+        });
+
+        auto start = Time::getHighResolutionTicks();
+        pd->getStateInformation(state);
+        auto saveTime = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1000.0;
+
+        isSaving = false;
+        audioThread.join();
+        return std::make_pair(saveTime, maxLockWait);
+    };
+
+    MemoryBlock state;
+    auto [firstSaveTime, firstLockWait] = measureSave(state);
+    auto [secondSaveTime, secondLockWait] = measureSave(state);
+
+    std::cout << "STATE SERIALISATION BENCHMARK: " << patchKilobytes << "kB patch, first save " << firstSaveTime << "ms (max lock wait " << firstLockWait << "ms), unchanged save " << secondSaveTime << "ms (max lock wait " << secondLockWait << "ms), state size " << state.getSize() / 1024 << "kB" << std::endl;
+
+    pd->patches.removeFirstMatchingValue(patch);
+}
+
+// Compares opening patch text directly, like we do when restoring the DAW state, against writing it to a temporary file and opening that
+void runPatchLoadBenchmark(PluginProcessor* pd, int patchKilobytes)
+{
+    auto const patchText = generatePatchText(patchKilobytes);
+    int const numLoads = 10;
+
+    auto textLoadTime = 0.0;
+    auto fileLoadTime = 0.0;
+    for (int i = 0; i < numLoads; i++) {
+        auto start = Time::getHighResolutionTicks();
+        auto textPatch = pd->loadPatch(patchText);
+        auto middle = Time::getHighResolutionTicks();
+
+        auto patchFile = File::createTempFile(".pd");
+        patchFile.replaceWithText(patchText);
+        auto filePatch = pd->loadPatch(URL(patchFile));
+        auto end = Time::getHighResolutionTicks();
+
+        textLoadTime += Time::highResolutionTicksToSeconds(middle - start);
+        fileLoadTime += Time::highResolutionTicksToSeconds(end - middle);
+
+        pd->patches.removeFirstMatchingValue(textPatch);
+        pd->patches.removeFirstMatchingValue(filePatch);
+        patchFile.deleteFile();
+    }
+
+    std::cout << "PATCH LOAD BENCHMARK: " << patchKilobytes << "kB patch, from text " << textLoadTime * 1000.0 / numLoads << "ms, through temp file " << fileLoadTime * 1000.0 / numLoads << "ms" << std::endl;
+}
+
+// Zooms in and out on a patch with lots of text, and counts how much text we rasterise and how many texture uploads that takes
+void runTextRenderBenchmark(PluginEditor* editor, int numObjects)
+{
+    String patchText = "#N canvas 0 0 1200 800 12;\n";
+    for (int i = 0; i < numObjects; i++) {
+        auto const x = (i % 50) * 130;
+        auto const y = (i / 50) * 40;
+        switch (i % 3) {
+        case 0:
+            patchText += "#X obj " + String(x) + " " + String(y) + " f " + String(i) + ";\n";
+            break;
+        case 1:
+            patchText += "#X msg " + String(x) + " " + String(y) + " set " + String(i) + ";\n";
+            break;
+        default:
+            patchText += "#X text " + String(x) + " " + String(y) + " comment " + String(i) + ";\n";
+            break;
+        }
+    }
+
+    auto* cnv = editor->getTabComponent().openPatch(patchText);
+    if (!cnv)
+        return;
+
+    auto* nvg = editor->nvgSurface.getRawContext();
+    auto const zoomLevels = std::vector<float> { 1.0f, 1.25f, 1.5f, 2.0f, 1.5f, 1.25f, 1.0f, 0.75f, 0.5f, 0.75f, 1.0f };
+
+    // Render once, so we only measure what changes when zooming
+    editor->nvgSurface.invalidateAll();
+    editor->nvgSurface.render();
+    nvg = editor->nvgSurface.getRawContext();
+    if (!nvg) {
+        editor->getTabComponent().closeTab(cnv);
+        return;
+    }
+
+    auto const before = TextAtlas::getForContext(nvg).getStatistics();
+    std::vector<double> frameTimes;
+    for (int repeat = 0; repeat < 3; repeat++) {
+        for (auto const zoom : zoomLevels) {
+            cnv->zoomScale = zoom;
+            editor->nvgSurface.invalidateAll();
+
+            auto const start = Time::getHighResolutionTicks();
+            editor->nvgSurface.render();
+            frameTimes.push_back(Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1000.0);
+        }
+    }
+    auto const after = TextAtlas::getForContext(nvg).getStatistics();
+
+    cnv->zoomScale = 1.0f;
+    editor->getTabComponent().closeTab(cnv);
+
+    std::sort(frameTimes.begin(), frameTimes.end());
+    auto const average = std::accumulate(frameTimes.begin(), frameTimes.end(), 0.0) / static_cast<double>(frameTimes.size());
+    std::cout << "TEXT RENDER BENCHMARK: " << numObjects << " objects, " << frameTimes.size() << " zoom steps, frame time avg " << average << "ms, max " << frameTimes.back() << "ms, "
+              << after.numRendered - before.numRendered << " texts rendered, " << after.numUploads - before.numUploads << " texture uploads, " << after.numEvictions - before.numEvictions << " pages evicted" << std::endl;
+}
+
+// Measures a synchronise that updates every object, like after undo, against one that only updates the objects that changed in pd, like after an edit
+void runSynchroniseBenchmark(PluginEditor* editor, int numObjects)
+{
+    String patchText = "#N canvas 0 0 1200 800 12;\n";
+    for (int i = 0; i < numObjects; i++) {
+        patchText += "#X obj " + String((i % 50) * 130) + " " + String((i / 50) * 40) + " f " + String(i) + ";\n";
+    }
+    for (int i = 1; i < numObjects; i++) {
+        patchText += "#X connect " + String(i - 1) + " 0 " + String(i) + " 1;\n";
+    }
+
+    auto* cnv = editor->getTabComponent().openPatch(patchText);
+    if (!cnv)
+        return;
+
+    int const numSyncs = 20;
+    auto measureSync = [cnv, numSyncs](bool onlyChangedObjects) {
+        auto start = Time::getHighResolutionTicks();
+        for (int i = 0; i < numSyncs; i++) {
+            cnv->performSynchronise(onlyChangedObjects);
+        }
+        return Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1000.0 / numSyncs;
+    };
+
+    // The first sync stores the state of every object, so it isn't measured
+    cnv->performSynchronise();
+    auto const fullSyncTime = measureSync(false);
+    auto const incrementalSyncTime = measureSync(true);
+
+    editor->getTabComponent().closeTab(cnv);
+
+    std::cout << "SYNCHRONISE BENCHMARK: " << numObjects << " objects, full sync " << fullSyncTime << "ms, sync of changed objects " << incrementalSyncTime << "ms" << std::endl;
+}
+
+// Renders a large patch into an offscreen framebuffer at several zoom levels, and measures how long building the NanoVG paths takes for
+// the whole canvas, only the objects and only the connections, and how long it takes to flush that to the GPU
+// It renders with the editor's NanoVG context, so it needs a GPU. It runs in test builds with ENABLE_BENCHMARKS, which run in the standalone app anyway
+void runCanvasRenderBenchmark(PluginEditor* editor, int numObjects)
+{
+    // Chains of objects, with an extra connection that crosses over to the next chain
+    String patchText = "#N canvas 0 0 1200 800 12;\n";
+    String connectionText;
+    int const chainLength = 10;
+    for (int i = 0; i < numObjects; i++) {
+        auto const x = (i / chainLength) * 110;
+        auto const y = (i % chainLength) * 50;
+        patchText += "#X obj " + String(x) + " " + String(y) + " + " + String(i) + ";\n";
+
+        if (i % chainLength != chainLength - 1 && i + 1 < numObjects)
+            connectionText += "#X connect " + String(i) + " 0 " + String(i + 1) + " 0;\n";
+        if (i + chainLength + 1 < numObjects)
+            connectionText += "#X connect " + String(i) + " 0 " + String(i + chainLength + 1) + " 1;\n";
+    }
+
+    auto* cnv = editor->getTabComponent().openPatch(patchText + connectionText);
+    auto* nvg = editor->nvgSurface.getRawContext();
+    if (!cnv || !nvg || !cnv->viewport || !editor->nvgSurface.makeContextActive()) {
+        if (cnv)
+            editor->getTabComponent().closeTab(cnv);
+        return;
+    }
+
+    int const width = 1920;
+    int const height = 1080;
+    int const numFrames = 50;
+
+    // Like the invalid region that NVGSurface passes in, this is relative to the viewport
+    auto const area = Rectangle<int>(0, 0, width, height);
+
+    NVGFramebuffer framebuffer;
+    auto renderFrame = [&](std::function<void()> const& render) {
+        double drawTime = 0.0;
+        double flushTime = 0.0;
+        framebuffer.bind(nvg, width, height);
+        for (int frame = 0; frame < numFrames; frame++) {
+            nvgViewport(0, 0, width, height);
+            nvgClear(nvg);
+
+            auto const start = Time::getHighResolutionTicks();
+            nvgBeginFrame(nvg, width, height, 1.0f);
+            render();
+            auto const middle = Time::getHighResolutionTicks();
+            TextAtlas::uploadPendingChanges(nvg);
+            nvgEndFrame(nvg);
+            auto const end = Time::getHighResolutionTicks();
+
+            drawTime += Time::highResolutionTicksToSeconds(middle - start) * 1000.0;
+            flushTime += Time::highResolutionTicksToSeconds(end - middle) * 1000.0;
+        }
+        framebuffer.unbind();
+        return std::make_pair(drawTime / numFrames, flushTime / numFrames);
+    };
+
+    for (auto const zoom : { 0.25f, 0.5f, 1.0f, 2.0f }) {
+        cnv->zoomScale = zoom;
+
+        auto const canvasTimes = renderFrame([cnv, nvg, area]() {
+            cnv->performRender(nvg, area);
+        });
+        auto const canvasDrawCalls = cnv->renderStatistics.getNumDrawCalls();
+
+        // Same transform and region as performRender, so all three measurements cover the same part of the canvas
+        NVGRenderStatistics objectStatistics, connectionStatistics;
+        auto renderOnCanvas = [&, cnv, nvg, zoom, area](bool objects) {
+            auto const viewPosition = cnv->viewport->getViewPosition();
+            auto const canvasArea = area.translated(viewPosition.x, viewPosition.y) / zoom;
+
+            NVGScopedState scopedState(nvg);
+            nvgTranslate(nvg, -viewPosition.x, -viewPosition.y);
+            nvgScale(nvg, zoom, zoom);
+
+            auto& statistics = objects ? objectStatistics : connectionStatistics;
+            statistics = {};
+            NVGDrawCallCounter drawCallCounter(nvg, statistics);
+            if (objects)
+                cnv->renderAllObjects(nvg, canvasArea);
+            else
+                cnv->renderAllConnections(nvg, canvasArea);
+        };
+
+        auto const objectTimes = renderFrame([&renderOnCanvas]() { renderOnCanvas(true); });
+        auto const connectionTimes = renderFrame([&renderOnCanvas]() { renderOnCanvas(false); });
+
+        std::cout << "CANVAS RENDER BENCHMARK: " << numObjects << " objects, zoom " << zoom << ", canvas " << canvasTimes.first << "ms + " << canvasTimes.second << "ms flush (" << canvasDrawCalls << " draw calls), objects "
+                  << objectTimes.first << "ms + " << objectTimes.second << "ms flush (" << objectStatistics.getNumDrawCalls() << " draw calls), connections " << connectionTimes.first << "ms + "
+                  << connectionTimes.second << "ms flush (" << connectionStatistics.getNumDrawCalls() << " draw calls)" << std::endl;
+    }
+
+    cnv->zoomScale = 1.0f;
+    editor->getTabComponent().closeTab(cnv);
+}
+
+// Pushes audio and MIDI through an AudioMidiFifo with a different block size every time, like a host with a variable block size does
+// Every 100 blocks there is a large sysex message, to make sure those get through as well
+void runAudioMidiFifoBenchmark(int numBlocks)
+{
+    int const pdBlockSize = pd::Instance::getBlockSize();
+    int const maxHostBlockSize = 1024;
+    int const sysexSize = 20000;
+
+    AudioMidiFifo fifo(2, maxHostBlockSize * 3);
+    AudioBuffer<float> hostBuffer(2, maxHostBlockSize);
+    AudioBuffer<float> pdBuffer(2, pdBlockSize);
+    MidiBuffer hostMidi;
+    MidiBuffer pdMidi;
+    hostMidi.ensureSize(sysexSize * 2);
+    pdMidi.ensureSize(sysexSize * 2);
+
+    Random random(numBlocks);
+    std::vector<uint8> sysex(sysexSize);
+    for (auto& byte : sysex) {
+        byte = static_cast<uint8>(random.nextInt(128));
+    }
+
+    int64 eventsWritten = 0;
+    int64 eventsRead = 0;
+    int64 bytesWritten = 0;
+    int64 bytesRead = 0;
+    double totalTime = 0.0;
+    double maxTime = 0.0;
+
+    for (int block = 0; block < numBlocks; block++) {
+        auto const numSamples = 1 + random.nextInt(maxHostBlockSize);
+
+        hostMidi.clear();
+        for (int i = 0; i < 16; i++) {
+            hostMidi.addEvent(MidiMessage::noteOn(1, 40 + i, 0.5f), random.nextInt(numSamples));
+        }
+        if (block % 100 == 0) {
+            hostMidi.addEvent(MidiMessage::createSysExMessage(sysex.data(), sysexSize), 0);
+        }
+        for (auto const event : hostMidi) {
+            eventsWritten++;
+            bytesWritten += event.numBytes;
+        }
+
+        auto const start = Time::getHighResolutionTicks();
+        fifo.writeAudioAndMidi(dsp::AudioBlock<float>(hostBuffer).getSubBlock(0, numSamples), hostMidi);
+        while (fifo.getNumSamplesAvailable() >= pdBlockSize) {
+            pdMidi.clear();
+            fifo.readAudioAndMidi(pdBuffer, pdMidi);
+            for (auto const event : pdMidi) {
+                eventsRead++;
+                bytesRead += event.numBytes;
+            }
+        }
+        auto const time = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1000000.0;
+        totalTime += time;
+        maxTime = std::max(maxTime, time);
+    }
+
+    // Whatever is still in the fifo is less than one pd block
+    std::cout << "AUDIO MIDI FIFO BENCHMARK: " << numBlocks << " blocks, avg " << totalTime / numBlocks << "us max " << maxTime << "us per block, "
+              << eventsRead << "/" << eventsWritten << " events, " << bytesRead << "/" << bytesWritten << " bytes" << std::endl;
+
+    if (fifo.getAndResetNumDroppedMidiEvents() > 0) {
+        failedChecks.add("AudioMidiFifo dropped MIDI events");
+    }
+}
+
+// Compares finding the min/max of every pixel column of a large array, like we do when drawing it, using the pyramid vs. reading every value
+void runArrayPyramidBenchmark(int numValues)
+{
+    Random random(numValues);
+    std::vector<float> values(numValues);
+    for (auto& value : values) {
+        value = random.nextFloat() * 2.0f - 1.0f;
+    }
+
+    MinMaxPyramid pyramid;
+
+    auto start = Time::getHighResolutionTicks();
+    pyramid.rebuild(values.data(), values.size());
+    auto buildTime = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1000.0;
+
+    // Like drawing into the array with the mouse
+    start = Time::getHighResolutionTicks();
+    for (int i = 0; i < 1000; i++) {
+        auto const index = random.nextInt(numValues - 100);
+        pyramid.update(values.data(), index, index + 100);
+    }
+    auto updateTime = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1000.0 / 1000.0;
+
+    int const numColumns = 1000;
+    float checksum = 0.0f;
+
+    start = Time::getHighResolutionTicks();
+    for (int column = 0; column < numColumns; column++) {
+        auto const range = std::minmax_element(values.begin() + static_cast<size_t>(column) * numValues / numColumns, values.begin() + static_cast<size_t>(column + 1) * numValues / numColumns);
+        checksum += *range.second - *range.first;
+    }
+    auto middle = Time::getHighResolutionTicks();
+    for (int column = 0; column < numColumns; column++) {
+        auto const range = pyramid.getMinMax(values.data(), static_cast<size_t>(column) * numValues / numColumns, static_cast<size_t>(column + 1) * numValues / numColumns);
+        checksum -= range.max - range.min;
+    }
+    auto end = Time::getHighResolutionTicks();
+
+    auto linearTime = Time::highResolutionTicksToSeconds(middle - start) * 1000.0;
+    auto pyramidTime = Time::highResolutionTicksToSeconds(end - middle) * 1000.0;
+
+    std::cout << "ARRAY PYRAMID BENCHMARK: " << numValues << " values, build " << buildTime << "ms, update " << updateTime << "ms, " << numColumns << " columns linear " << linearTime << "ms, pyramid " << pyramidTime << "ms (" << checksum << ")" << std::endl;
+}
+
+// Renders a patch offline through libpd and through the C code that Heavy generates for it, and compares the output and the time per block
+// This needs the Heavy toolchain and a C compiler. Patches that Heavy can't compile are skipped
+void runHeavyComparisonBenchmark(PluginProcessor* pd, File const& patchFile, double seconds)
+{
+#if JUCE_WINDOWS
+    auto const toolchainBin = ProjectInfo::appDataDir.getChildFile("Toolchain").getChildFile("usr").getChildFile("bin");
+    auto const heavy = toolchainBin.getChildFile("Heavy").getChildFile("Heavy.exe");
+    auto const compiler = toolchainBin.getChildFile("g++.exe").getFullPathName();
+    auto const libraryName = String("bench.dll");
+#elif JUCE_MAC
+    auto const heavy = ProjectInfo::appDataDir.getChildFile("Toolchain").getChildFile("bin").getChildFile("Heavy").getChildFile("Heavy");
+    auto const compiler = String("c++");
+    auto const libraryName = String("libbench.dylib");
+#else
+    auto const heavy = ProjectInfo::appDataDir.getChildFile("Toolchain").getChildFile("bin").getChildFile("Heavy").getChildFile("Heavy");
+    auto const compiler = String("c++");
+    auto const libraryName = String("libbench.so");
+#endif
+
+    auto const patchName = patchFile.getFileName();
+    if (!heavy.existsAsFile()) {
+        std::cout << "HEAVY COMPARISON BENCHMARK: " << patchName << " skipped, the Heavy toolchain is not installed" << std::endl;
+        return;
+    }
+
+    auto buildDir = File::getSpecialLocation(File::tempDirectory).getNonexistentChildFile("HeavyBenchmark", "", false);
+    buildDir.createDirectory();
+
+    ChildProcess process;
+    process.start(StringArray { heavy.getFullPathName(), patchFile.getFullPathName(), "-o", buildDir.getFullPathName(), "-n", "bench", "-p", patchFile.getParentDirectory().getFullPathName() });
+    process.waitForProcessToFinish(-1);
+
+    auto const library = buildDir.getChildFile(libraryName);
+    if (process.getExitCode() == 0) {
+        StringArray compileArgs = { compiler, "-O3", "-shared", "-fPIC", "-o", library.getFullPathName(), "-x", "c" };
+        for (auto const& file : buildDir.getChildFile("c").findChildFiles(File::findFiles, false, "*.c")) {
+            compileArgs.add(file.getFullPathName());
+        }
+        compileArgs.add("-x");
+        compileArgs.add("c++");
+        for (auto const& file : buildDir.getChildFile("c").findChildFiles(File::findFiles, false, "*.cpp")) {
+            compileArgs.add(file.getFullPathName());
+        }
+
+        process.start(compileArgs);
+        process.waitForProcessToFinish(-1);
+    }
+
+    DynamicLibrary heavyLibrary;
+    if (!library.existsAsFile() || !heavyLibrary.open(library.getFullPathName())) {
+        std::cout << "HEAVY COMPARISON BENCHMARK: " << patchName << " skipped, Heavy couldn't compile it" << std::endl;
+        buildDir.deleteRecursively();
+        return;
+    }
+
+    // Heavy's C API, from HvHeavy.h and Heavy_bench.h
+    auto* heavyNew = reinterpret_cast<void* (*)(double)>(heavyLibrary.getFunction("hv_bench_new"));
+    auto* heavyDelete = reinterpret_cast<void (*)(void*)>(heavyLibrary.getFunction("hv_delete"));
+    auto* heavyProcess = reinterpret_cast<int (*)(void*, float*, float*, int)>(heavyLibrary.getFunction("hv_processInline"));
+    auto* heavyNumInputs = reinterpret_cast<int (*)(void*)>(heavyLibrary.getFunction("hv_getNumInputChannels"));
+    auto* heavyNumOutputs = reinterpret_cast<int (*)(void*)>(heavyLibrary.getFunction("hv_getNumOutputChannels"));
+
+    if (!heavyNew || !heavyDelete || !heavyProcess || !heavyNumInputs || !heavyNumOutputs) {
+        std::cout << "HEAVY COMPARISON BENCHMARK: " << patchName << " skipped, the compiled patch doesn't export the Heavy API" << std::endl;
+        heavyLibrary.close();
+        buildDir.deleteRecursively();
+        return;
+    }
+
+    pd->setThis();
+    auto const blockSize = pd::Instance::getBlockSize();
+    auto const sampleRate = static_cast<double>(sys_getsr());
+    auto const numBlocks = static_cast<int>(seconds * sampleRate / blockSize);
+
+    // Render in a separate instance, so the patches that are open in the editor don't end up in the output or the timing
+    // Like the offline renderer, we drive performDSP directly, so the oversampler must be off
+    auto isolated = std::make_unique<PluginProcessor>();
+    isolated->oversampling = 0;
+    isolated->prepareToPlay(sampleRate, blockSize);
+    isolated->setThis();
+
+    auto const numInputs = isolated->getTotalNumInputChannels();
+    auto const numOutputs = isolated->getTotalNumOutputChannels();
+
+    auto measureBlocks = [numBlocks](std::function<void(int)> const& processBlock) {
+        double totalTime = 0.0, maxTime = 0.0;
+        for (int block = 0; block < numBlocks; block++) {
+            auto start = Time::getHighResolutionTicks();
+            processBlock(block);
+            auto const blockTime = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1000000.0;
+            totalTime += blockTime;
+            maxTime = std::max(maxTime, blockTime);
+        }
+        return std::make_pair(totalTime / std::max(numBlocks, 1), maxTime);
+    };
+
+    std::vector<float> libpdInput(numInputs * blockSize, 0.0f);
+    std::vector<float> libpdOutput(static_cast<size_t>(numBlocks) * numOutputs * blockSize, 0.0f);
+    auto patch = isolated->loadPatch(URL(patchFile));
+    isolated->lockAudioThread();
+    auto [libpdAverage, libpdMax] = measureBlocks([&](int block) {
+        isolated->performDSP(libpdInput.data(), libpdOutput.data() + static_cast<size_t>(block) * numOutputs * blockSize);
+    });
+    isolated->unlockAudioThread();
+    isolated->patches.removeFirstMatchingValue(patch);
+    patch = nullptr;
+    isolated.reset();
+    pd->setThis();
+
+    auto* context = heavyNew(sampleRate);
+    auto const heavyOutputs = heavyNumOutputs(context);
+    std::vector<float> heavyInput(heavyNumInputs(context) * blockSize, 0.0f);
+    std::vector<float> heavyOutput(static_cast<size_t>(numBlocks) * heavyOutputs * blockSize, 0.0f);
+    auto [heavyAverage, heavyMax] = measureBlocks([&](int block) {
+        heavyProcess(context, heavyInput.data(), heavyOutput.data() + static_cast<size_t>(block) * heavyOutputs * blockSize, blockSize);
+    });
+    heavyDelete(context);
+    heavyLibrary.close();
+    buildDir.deleteRecursively();
+
+    // Both render the channels of each block one after another
+    float maxError = 0.0f;
+    for (size_t block = 0; block < static_cast<size_t>(numBlocks); block++) {
+        for (int channel = 0; channel < std::min(numOutputs, heavyOutputs); channel++) {
+            auto const* libpdSamples = libpdOutput.data() + (block * numOutputs + channel) * blockSize;
+            auto const* heavySamples = heavyOutput.data() + (block * heavyOutputs + channel) * blockSize;
+            for (int i = 0; i < blockSize; i++) {
+                maxError = std::max(maxError, std::abs(libpdSamples[i] - heavySamples[i]));
+            }
+        }
+    }
+
+    std::cout << "HEAVY COMPARISON BENCHMARK: " << patchName << ", " << seconds << "s, libpd avg " << libpdAverage << "us max " << libpdMax << "us per block, Heavy avg " << heavyAverage << "us max " << heavyMax << "us per block, max sample error " << maxError << std::endl;
+}
+
+// Checks that functions queued from the GUI and MIDI coming out of pd are handled in the order they were queued in
+// We queue a function that outputs a note, make pd output a note, and queue another function that outputs a note. The notes should come out in that order
+void runMessageOrderTest(PluginProcessor* pd)
+{
+    auto const patchText = "#N canvas 0 50 450 300 12;\n"
+                           "#X obj 20 20 r order_test;\n"
+                           "#X obj 20 50 noteout;\n"
+                           "#X connect 0 0 1 0;\n";
+
+    // Make sure the audio device doesn't call processBlock at the same time as we do
+    pd->suspendProcessing(true);
+    auto patch = pd->loadPatch(patchText);
+
+    // Only note-offs, in case this ends up at a MIDI device
+    pd->enqueueFunctionAsync([pd]() { pd->receiveNoteOn(1, 61, 0); });
+    pd->lockAudioThread();
+    pd->sendFloat("order_test", 62);
+    pd->unlockAudioThread();
+    pd->enqueueFunctionAsync([pd]() { pd->receiveNoteOn(1, 63, 0); });
+
+    // With a variable block size, the output can be delayed by a block
+    AudioBuffer<float> buffer(jmax(1, pd->getTotalNumInputChannels(), pd->getTotalNumOutputChannels()), jmax(pd::Instance::getBlockSize(), pd->AudioProcessor::getBlockSize()));
+    StringArray notes;
+    for (int block = 0; block < 4; block++) {
+        MidiBuffer midi;
+        buffer.clear();
+        pd->processBlock(buffer, midi);
+
+        for (auto const event : midi) {
+            int device;
+            auto const message = MidiDeviceManager::convertFromSysExFormat(event.getMessage(), device);
+            if (message.isNoteOff())
+                notes.add(String(message.getNoteNumber()));
+        }
+    }
+
+    pd->patches.removeFirstMatchingValue(patch);
+    pd->suspendProcessing(false);
+
+    if (!pd->producesMidi())
+        return;
+
+    if (notes.joinIntoString(" ") == "61 62 63") {
+        std::cout << "MESSAGE ORDER TEST PASSED" << std::endl;
+    } else {
+        std::cout << "MESSAGE ORDER TEST FAILED: expected notes 61 62 63, got " << notes.joinIntoString(" ") << std::endl;
+        failedChecks.add("queued functions and MIDI from pd were handled out of order");
+    }
+}
+
+// Drives processBlock with automation, playhead changes, MIDI and messages from the GUI, and reports everything on the audio thread that allocates or locks
+// Only does something in builds with ENABLE_REALTIME_AUDIT
+void runRealtimeSafetyAudit(PluginProcessor* pd, int numBlocks)
+{
+    struct AuditPlayHead : public AudioPlayHead {
+        Optional<PositionInfo> getPosition() const override
+        {
+            return position;
+        }
+
+        PositionInfo position;
+    };
+
+    auto const patchText = "#N canvas 0 50 450 300 12;\n"
+                           "#X obj 20 20 r param1;\n"
+                           "#X obj 20 50 osc~;\n"
+                           "#X obj 20 80 dac~;\n"
+                           "#X obj 120 20 r _playhead;\n"
+                           "#X obj 120 50 route bpm position;\n"
+                           "#X obj 220 20 notein;\n"
+                           "#X obj 220 50 mtof;\n"
+                           "#X obj 220 80 r audit;\n"
+                           "#X obj 320 50 noteout;\n"
+                           "#X connect 0 0 1 0;\n"
+                           "#X connect 1 0 2 0;\n"
+                           "#X connect 1 0 2 1;\n"
+                           "#X connect 3 0 4 0;\n"
+                           "#X connect 5 0 6 0;\n"
+                           "#X connect 6 0 1 0;\n"
+                           "#X connect 7 0 1 0;\n"
+                           "#X connect 5 0 8 0;\n"
+                           "#X connect 5 1 8 1;\n";
+
+    // Make sure the audio device doesn't call processBlock at the same time as we do
+    pd->suspendProcessing(true);
+
+    auto patch = pd->loadPatch(patchText);
+    pd->enableAudioParameter("param1");
+
+    PlugDataParameter* parameter = nullptr;
+    for (auto* param : pd->getParameters()) {
+        if (auto* pldParam = dynamic_cast<PlugDataParameter*>(param); pldParam && pldParam->isEnabled() && pldParam->getTitle() == "param1")
+            parameter = pldParam;
+    }
+
+    auto* previousPlayHead = pd->getPlayHead();
+    AuditPlayHead playHead;
+    pd->setPlayHead(&playHead);
+
+    auto const blockSize = jmax(pd::Instance::getBlockSize(), pd->AudioProcessor::getBlockSize());
+    AudioBuffer<float> buffer(jmax(1, pd->getTotalNumInputChannels(), pd->getTotalNumOutputChannels()), blockSize);
+    MidiBuffer midi;
+    Random random(numBlocks);
+
+    RealtimeAudit::clearViolations();
+
+    for (int block = 0; block < numBlocks; block++) {
+        if (parameter)
+            parameter->setValue(random.nextFloat());
+
+        playHead.position.setIsPlaying((block / 100) % 2 == 0);
+        playHead.position.setBpm(120.0 + block % 10);
+        playHead.position.setTimeInSamples(static_cast<int64>(block) * blockSize);
+        playHead.position.setPpqPosition(block * 0.1);
+        playHead.position.setTimeSignature(AudioPlayHead::TimeSignature { 3 + block % 2, 4 });
+
+        midi.clear();
+        midi.addEvent(MidiMessage::noteOn(1, 60 + block % 12, 0.8f), 0);
+        midi.addEvent(MidiMessage::noteOff(1, 60 + block % 12), blockSize / 2);
+
+        // Like a GUI object sending a message to pd
+        pd->enqueueFunctionAsync([pd, block]() {
+            pd->sendFloat("audit", 220.0f + block % 100);
+        });
+
+        buffer.clear();
+        pd->processBlock(buffer, midi);
+    }
+
+    auto violations = RealtimeAudit::getViolations();
+
+    pd->setPlayHead(previousPlayHead);
+    pd->patches.removeFirstMatchingValue(patch);
+    pd->suspendProcessing(false);
+
+    if (violations.empty()) {
+        std::cout << "REALTIME SAFETY AUDIT PASSED: " << numBlocks << " blocks" << std::endl;
+        return;
+    }
+
+    // The same violation usually happens in every block, so only report each stack trace once
+    std::map<String, int> occurrences;
+    String report;
+    for (auto const& violation : violations) {
+        auto const key = violation.type + "\n" + violation.stackTrace;
+        if (occurrences[key]++ == 0) {
+            report += "\n\n" + violation.type + "\n--------------------------------------------------------------------------\n" + violation.stackTrace;
+        }
+    }
+
+    ProjectInfo::appDataDir.getChildFile("realtime-violations.md").replaceWithText(report);
+    std::cout << "REALTIME SAFETY AUDIT FAILED: " << violations.size() << " violations in " << numBlocks << " blocks, " << occurrences.size() << " unique" << report << std::endl;
+    failedChecks.add("realtime safety audit found " + String(occurrences.size()) + " unique violations");
+}
+
 void runTests(PluginEditor* editor)
 {
+    // Benchmarks only print their results, and some take a while, so they only run in builds with ENABLE_BENCHMARKS
+#if ENABLE_BENCHMARKS
+    runAutocompleteBenchmark(*editor->pd->objectLibrary, ProjectInfo::appDataDir.getChildFile("Abstractions"));
+    runCanvasCullingBenchmark(1000);
+    runCanvasCullingBenchmark(10000);
+    editor->pd->setThis();
+    runMessageDispatcherBenchmark(1000);
+    runMessageDispatcherBenchmark(10000);
+    runStateSerialisationBenchmark(editor->pd, 10);
+    runStateSerialisationBenchmark(editor->pd, 100);
+    runStateSerialisationBenchmark(editor->pd, 1000);
+    runPatchLoadBenchmark(editor->pd, 10);
+    runPatchLoadBenchmark(editor->pd, 100);
+    runAudioMidiFifoBenchmark(100000);
+    runArrayPyramidBenchmark(1000000);
+    runArrayPyramidBenchmark(10000000);
+    runTextRenderBenchmark(editor, 5000);
+    runSynchroniseBenchmark(editor, 1000);
+    runSynchroniseBenchmark(editor, 10000);
+    runSynchroniseBenchmark(editor, 50000);
+    runCanvasRenderBenchmark(editor, 1000);
+    runCanvasRenderBenchmark(editor, 10000);
+#endif
+
+    runMessageOrderTest(editor->pd);
+
+#if ENABLE_REALTIME_AUDIT
+    runRealtimeSafetyAudit(editor->pd, 1000);
+#endif
+
+    // Compiles every help patch with Heavy, so this takes a long time and needs the toolchain. Only runs in builds with ENABLE_HEAVY_COMPARISON
+#if ENABLE_HEAVY_COMPARISON
+    for (auto& file : OSUtils::iterateDirectory(ProjectInfo::appDataDir.getChildFile("Documentation"), true, true)) {
+        if (file.hasFileExtension(".pd")) {
+            runHeavyComparisonBenchmark(editor->pd, file, 10.0);
+        }
+    }
+#endif
+
     static std::vector<File> allHelpfiles = {};
     // Open every helpfile, this will make sure it initialises and closes every object at least once (but probasbly a whole bunch of times in different contexts)
     // Run with AddressSanitizer, UBSanitizer or ThreadSanitizer to find all memory, UB and threading problems